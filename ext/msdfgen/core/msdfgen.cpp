@@ -3,6 +3,18 @@
 
 #include "arithmetics.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#ifndef __EMSCRIPTEN__
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
 namespace msdfgen {
 
 struct MultiDistance {
@@ -439,4 +451,348 @@ void generateMSDF_legacy(Bitmap<FloatRGB> &output, const Shape &shape, double ra
         msdfErrorCorrection(output, edgeThreshold/(scale*range));
 }
 
+// Tile size of generateMSDF_RGBA8. Tiles are scheduled by rows; each row band culls edges separately for every span of columns.
+#define MSDFGEN_TILE_ROWS 8
+#define MSDFGEN_TILE_COLUMNS 16
+
+#ifndef __EMSCRIPTEN__
+/// Persistent worker threads shared by all parallel generator calls. The calling thread also takes tasks.
+class WorkerPool {
+
+public:
+    static WorkerPool & instance() {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    int threadCount() const {
+        return int(threads.size())+1;
+    }
+
+    /// Runs task(0) ... task(taskCount-1) on up to maxThreads threads and waits for all of them.
+    void run(int taskCount, int maxThreads, const std::function<void(int)> &task) {
+        std::lock_guard<std::mutex> runLock(runMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            currentTask = &task;
+            currentTaskCount = taskCount;
+            nextTask = 0;
+            slots = std::min(maxThreads-1, int(threads.size()));
+            ++generation;
+        }
+        wake.notify_all();
+        drain(task);
+        std::unique_lock<std::mutex> lock(mutex);
+        slots = 0;
+        done.wait(lock, [this] { return busy == 0; });
+        currentTask = NULL;
+    }
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex runMutex;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int)> *currentTask;
+    int currentTaskCount;
+    std::atomic<int> nextTask;
+    int slots;
+    int busy;
+    int generation;
+    bool quit;
+
+    WorkerPool() : currentTask(NULL), currentTaskCount(0), nextTask(0), slots(0), busy(0), generation(0), quit(false) {
+        int count = int(std::thread::hardware_concurrency())-1;
+        for (int i = 0; i < count; ++i)
+            threads.push_back(std::thread([this] { work(); }));
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (std::vector<std::thread>::iterator thread = threads.begin(); thread != threads.end(); ++thread)
+            thread->join();
+    }
+
+    void drain(const std::function<void(int)> &task) {
+        for (int i; (i = nextTask++) < currentTaskCount;)
+            task(i);
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        int seen = generation;
+        for (;;) {
+            wake.wait(lock, [&] { return quit || generation != seen; });
+            if (quit)
+                return;
+            seen = generation;
+            if (slots <= 0)
+                continue;
+            --slots;
+            ++busy;
+            const std::function<void(int)> &task = *currentTask;
+            lock.unlock();
+            drain(task);
+            lock.lock();
+            if (--busy == 0)
+                done.notify_all();
+        }
+    }
+
+};
+#endif
+
+typedef std::vector<std::vector<const EdgeHolder *> > ContourEdges;
+
+/// Selects the edges that can be nearest for at least one channel somewhere in the rectangle [lo, hi].
+/// An edge is skipped only if, for each of its channels, another edge of the same contour is strictly closer to every point in the rectangle,
+/// so the per-contour channel minima, and with them the output, are unchanged.
+static void cullEdges(ContourEdges &output, const Shape &shape, Point2 lo, Point2 hi) {
+    const double margin = 1e-6;
+    output.resize(shape.contours.size());
+    std::vector<double> lower, upper;
+    for (size_t i = 0; i < shape.contours.size(); ++i) {
+        const Contour &contour = shape.contours[i];
+        lower.resize(contour.edges.size());
+        upper.resize(contour.edges.size());
+        double minUpper[3];
+        minUpper[0] = minUpper[1] = minUpper[2] = fabs(SignedDistance::INFINITE.distance);
+        for (size_t j = 0; j < contour.edges.size(); ++j) {
+            const EdgeHolder &edge = contour.edges[j];
+            // No point of the edge is closer than its bounding box.
+            double l = fabs(SignedDistance::INFINITE.distance), b = l, r = -l, t = -l;
+            edge->bounds(l, b, r, t);
+            double dx = std::max(0., std::max(l-hi.x, lo.x-r));
+            double dy = std::max(0., std::max(b-hi.y, lo.y-t));
+            lower[j] = sqrt(dx*dx+dy*dy);
+            // The reported distance never exceeds the distance to either end point.
+            upper[j] = fabs(SignedDistance::INFINITE.distance);
+            for (int k = 0; k < 2; ++k) {
+                Point2 end = edge->point(k);
+                double fx = std::max(fabs(end.x-lo.x), fabs(end.x-hi.x));
+                double fy = std::max(fabs(end.y-lo.y), fabs(end.y-hi.y));
+                upper[j] = std::min(upper[j], sqrt(fx*fx+fy*fy));
+            }
+            if (edge->color&RED) minUpper[0] = std::min(minUpper[0], upper[j]);
+            if (edge->color&GREEN) minUpper[1] = std::min(minUpper[1], upper[j]);
+            if (edge->color&BLUE) minUpper[2] = std::min(minUpper[2], upper[j]);
+        }
+        output[i].clear();
+        for (size_t j = 0; j < contour.edges.size(); ++j) {
+            const EdgeHolder &edge = contour.edges[j];
+            double cutoff = lower[j]-margin*(1+lower[j]);
+            if ((edge->color&RED && cutoff <= minUpper[0])
+                || (edge->color&GREEN && cutoff <= minUpper[1])
+                || (edge->color&BLUE && cutoff <= minUpper[2]))
+                output[i].push_back(&edge);
+        }
+    }
+}
+
+/// Same per-pixel computation as generateMSDF, over a subset of each contour's edges.
+static FloatRGB computeMultiDistance(const ContourEdges &contourEdges, const std::vector<int> &windings, std::vector<MultiDistance> &contourSD, Point2 p, double range) {
+    int contourCount = int(contourEdges.size());
+
+    struct EdgePoint {
+        SignedDistance minDistance;
+        const EdgeHolder *nearEdge;
+        double nearParam;
+    } sr, sg, sb;
+    sr.nearEdge = sg.nearEdge = sb.nearEdge = NULL;
+    sr.nearParam = sg.nearParam = sb.nearParam = 0;
+    double d = fabs(SignedDistance::INFINITE.distance);
+    double negDist = -SignedDistance::INFINITE.distance;
+    double posDist = SignedDistance::INFINITE.distance;
+    int winding = 0;
+
+    for (int i = 0; i < contourCount; ++i) {
+        EdgePoint r, g, b;
+        r.nearEdge = g.nearEdge = b.nearEdge = NULL;
+        r.nearParam = g.nearParam = b.nearParam = 0;
+
+        for (std::vector<const EdgeHolder *>::const_iterator it = contourEdges[i].begin(); it != contourEdges[i].end(); ++it) {
+            const EdgeHolder *edge = *it;
+            double param;
+            SignedDistance distance = (*edge)->signedDistance(p, param);
+            if ((*edge)->color&RED && distance < r.minDistance) {
+                r.minDistance = distance;
+                r.nearEdge = edge;
+                r.nearParam = param;
+            }
+            if ((*edge)->color&GREEN && distance < g.minDistance) {
+                g.minDistance = distance;
+                g.nearEdge = edge;
+                g.nearParam = param;
+            }
+            if ((*edge)->color&BLUE && distance < b.minDistance) {
+                b.minDistance = distance;
+                b.nearEdge = edge;
+                b.nearParam = param;
+            }
+        }
+        if (r.minDistance < sr.minDistance)
+            sr = r;
+        if (g.minDistance < sg.minDistance)
+            sg = g;
+        if (b.minDistance < sb.minDistance)
+            sb = b;
+
+        double medMinDistance = fabs(median(r.minDistance.distance, g.minDistance.distance, b.minDistance.distance));
+        if (medMinDistance < d) {
+            d = medMinDistance;
+            winding = -windings[i];
+        }
+        if (r.nearEdge)
+            (*r.nearEdge)->distanceToPseudoDistance(r.minDistance, p, r.nearParam);
+        if (g.nearEdge)
+            (*g.nearEdge)->distanceToPseudoDistance(g.minDistance, p, g.nearParam);
+        if (b.nearEdge)
+            (*b.nearEdge)->distanceToPseudoDistance(b.minDistance, p, b.nearParam);
+        medMinDistance = median(r.minDistance.distance, g.minDistance.distance, b.minDistance.distance);
+        contourSD[i].r = r.minDistance.distance;
+        contourSD[i].g = g.minDistance.distance;
+        contourSD[i].b = b.minDistance.distance;
+        contourSD[i].med = medMinDistance;
+        if (windings[i] > 0 && medMinDistance >= 0 && fabs(medMinDistance) < fabs(posDist))
+            posDist = medMinDistance;
+        if (windings[i] < 0 && medMinDistance <= 0 && fabs(medMinDistance) < fabs(negDist))
+            negDist = medMinDistance;
+    }
+    if (sr.nearEdge)
+        (*sr.nearEdge)->distanceToPseudoDistance(sr.minDistance, p, sr.nearParam);
+    if (sg.nearEdge)
+        (*sg.nearEdge)->distanceToPseudoDistance(sg.minDistance, p, sg.nearParam);
+    if (sb.nearEdge)
+        (*sb.nearEdge)->distanceToPseudoDistance(sb.minDistance, p, sb.nearParam);
+
+    MultiDistance msd;
+    msd.r = msd.g = msd.b = msd.med = SignedDistance::INFINITE.distance;
+    if (posDist >= 0 && fabs(posDist) <= fabs(negDist)) {
+        msd.med = SignedDistance::INFINITE.distance;
+        winding = 1;
+        for (int i = 0; i < contourCount; ++i)
+            if (windings[i] > 0 && contourSD[i].med > msd.med && fabs(contourSD[i].med) < fabs(negDist))
+                msd = contourSD[i];
+    } else if (negDist <= 0 && fabs(negDist) <= fabs(posDist)) {
+        msd.med = -SignedDistance::INFINITE.distance;
+        winding = -1;
+        for (int i = 0; i < contourCount; ++i)
+            if (windings[i] < 0 && contourSD[i].med < msd.med && fabs(contourSD[i].med) < fabs(posDist))
+                msd = contourSD[i];
+    }
+    for (int i = 0; i < contourCount; ++i)
+        if (windings[i] != winding && fabs(contourSD[i].med) < fabs(msd.med))
+            msd = contourSD[i];
+    if (median(sr.minDistance.distance, sg.minDistance.distance, sb.minDistance.distance) == msd.med) {
+        msd.r = sr.minDistance.distance;
+        msd.g = sg.minDistance.distance;
+        msd.b = sb.minDistance.distance;
+    }
+
+    FloatRGB rv;
+    rv.r = float(msd.r/range+.5);
+    rv.g = float(msd.g/range+.5);
+    rv.b = float(msd.b/range+.5);
+    return rv;
+}
+
+void generateMSDF_RGBA8(unsigned char *output, int width, int height, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate, double edgeThreshold, int threadCount) {
+    int w = width, h = height;
+    std::vector<int> windings;
+    windings.reserve(shape.contours.size());
+    for (std::vector<Contour>::const_iterator contour = shape.contours.begin(); contour != shape.contours.end(); ++contour)
+        windings.push_back(contour->winding());
+
+    bool correct = edgeThreshold > 0;
+    Vector2 threshold = correct ? edgeThreshold/(scale*range) : Vector2();
+    int halo = correct ? 1 : 0;
+    int tileCount = (h+MSDFGEN_TILE_ROWS-1)/MSDFGEN_TILE_ROWS;
+
+    // Each tile computes its own rows plus a halo row on each side, since error correction looks at vertical neighbors.
+    // Only that scratch is kept as floats; finished rows go straight to the output.
+    std::function<void(int)> tile = [&](int tileIndex) {
+        int first = tileIndex*MSDFGEN_TILE_ROWS;
+        int last = std::min(first+MSDFGEN_TILE_ROWS, h);
+        int haloFirst = std::max(first-halo, 0);
+        int haloLast = std::min(last+halo, h);
+        int rows = haloLast-haloFirst;
+
+        // Output rows map to shape rows through inverseYAxis.
+        int y0 = shape.inverseYAxis ? h-haloLast : haloFirst;
+        int y1 = shape.inverseYAxis ? h-haloFirst-1 : haloLast-1;
+
+        ContourEdges contourEdges;
+        std::vector<MultiDistance> contourSD(shape.contours.size());
+        std::vector<FloatRGB> pixels(w*rows);
+
+        for (int x0 = 0; x0 < w; x0 += MSDFGEN_TILE_COLUMNS) {
+            int x1 = std::min(x0+MSDFGEN_TILE_COLUMNS, w);
+            Point2 a = Vector2(x0+.5, y0+.5)/scale-translate;
+            Point2 b = Vector2(x1-.5, y1+.5)/scale-translate;
+            Point2 lo(std::min(a.x, b.x), std::min(a.y, b.y));
+            Point2 hi(std::max(a.x, b.x), std::max(a.y, b.y));
+            cullEdges(contourEdges, shape, lo, hi);
+
+            for (int row = haloFirst; row < haloLast; ++row) {
+                int y = shape.inverseYAxis ? h-row-1 : row;
+                for (int x = x0; x < x1; ++x) {
+                    Point2 p = Vector2(x+.5, y+.5)/scale-translate;
+                    pixels[(row-haloFirst)*w+x] = computeMultiDistance(contourEdges, windings, contourSD, p, range);
+                }
+            }
+        }
+
+        std::vector<int> clashes;
+        if (correct) {
+            for (int row = first; row < last; ++row) {
+                const FloatRGB *line = &pixels[(row-haloFirst)*w];
+                for (int x = 0; x < w; ++x) {
+                    if ((x > 0 && pixelClash(line[x], line[x-1], threshold.x))
+                        || (x < w-1 && pixelClash(line[x], line[x+1], threshold.x))
+                        || (row > 0 && pixelClash(line[x], line[x-w], threshold.y))
+                        || (row < h-1 && pixelClash(line[x], line[x+w], threshold.y)))
+                        clashes.push_back((row-haloFirst)*w+x);
+                }
+            }
+        }
+        for (std::vector<int>::const_iterator clash = clashes.begin(); clash != clashes.end(); ++clash) {
+            FloatRGB &pixel = pixels[*clash];
+            float med = median(pixel.r, pixel.g, pixel.b);
+            pixel.r = med, pixel.g = med, pixel.b = med;
+        }
+
+        for (int row = first; row < last; ++row) {
+            const FloatRGB *line = &pixels[(row-haloFirst)*w];
+            unsigned char *out = output+4*w*row;
+            for (int x = 0; x < w; ++x) {
+                *out++ = (unsigned char) clamp(int(line[x].r*0x100), 0xff);
+                *out++ = (unsigned char) clamp(int(line[x].g*0x100), 0xff);
+                *out++ = (unsigned char) clamp(int(line[x].b*0x100), 0xff);
+                *out++ = 0xff;
+            }
+        }
+    };
+
+#ifdef __EMSCRIPTEN__
+    (void) threadCount;
+    for (int i = 0; i < tileCount; ++i)
+        tile(i);
+#else
+    WorkerPool &pool = WorkerPool::instance();
+    if (threadCount <= 0)
+        threadCount = pool.threadCount();
+    threadCount = std::min(threadCount, tileCount);
+    if (threadCount <= 1) {
+        for (int i = 0; i < tileCount; ++i)
+            tile(i);
+    } else
+        pool.run(tileCount, threadCount, tile);
+#endif
+}
+
 }
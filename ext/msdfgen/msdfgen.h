@@ -37,6 +37,12 @@ void generatePseudoSDF(Bitmap<float> &output, const Shape &shape, double range,
 /// Generates a multi-channel signed distance field. Edge colors must be assigned first! (see edgeColoringSimple)
 void generateMSDF(Bitmap<FloatRGB> &output, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate, double edgeThreshold = 1.00000001);
 
+/// Generates a multi-channel signed distance field straight into 8-bit RGBA (alpha is 255), width*height*4 bytes, row 0 first.
+/// Rows are split into tiles that are generated on up to threadCount threads (0 for one per core) with per-tile edge culling.
+/// The result is byte for byte what generateMSDF produces after converting each channel with clamp(int(v*0x100), 0xff).
+/// Emscripten builds always run on the calling thread.
+void generateMSDF_RGBA8(unsigned char *output, int width, int height, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate, double edgeThreshold = 1.00000001, int threadCount = 0);
+
 // Original simpler versions of the previous functions, which work well under normal circumstances, but cannot deal with overlapping contours.
 void generateSDF_legacy(Bitmap<float> &output, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate);
 void generatePseudoSDF_legacy(Bitmap<float> &output, const Shape &shape, double range, const Vector2 &scale, const Vector2 &translate);
@@ -194,6 +194,7 @@ namespace SoLoud
 				mOggFrameOffset += b;
 			}
 
+			int rewinds = 0;
 			while (offset < aSamples)
 			{
 				mOggFrameSize = stb_vorbis_get_frame_float(mOgg, NULL, &mOggOutputs);
@@ -203,12 +204,17 @@ namespace SoLoud
 				mOffset += b;
 				offset += b;
 				mOggFrameOffset += b;
-				if (mOffset >= mParent->mSampleCount)
+				// The sample count is only an estimate, so the data can run out before it is reached.
+				// Treat that as the end too, otherwise this loop never finishes.
+				if (mOffset >= mParent->mSampleCount || mOggFrameSize <= 0)
 				{
-					if (mFlags & AudioSourceInstance::LOOPING)
+					// A stream with no audio at all would rewind forever, so give up after the second try.
+					if ((mFlags & AudioSourceInstance::LOOPING) && rewinds++ < 2)
 					{
 						stb_vorbis_seek_start(mOgg);
-						mOffset = aSamples - offset;
+						mOggFrameSize = 0;
+						mOggFrameOffset = 0;
+						mOffset = 0;
 						mLoopCount++;
 					}
 					else
@@ -216,7 +222,8 @@ namespace SoLoud
 						unsigned int i;
 						for (i = 0; i < channels; i++)
 							memset(aBuffer + offset + i * aSamples, 0, sizeof(float) * (aSamples - offset));
-						mOffset += aSamples - offset;
+						if (mOffset < mParent->mSampleCount)
+							mOffset = mParent->mSampleCount;
 						offset = aSamples;
 					}
 				}
@@ -7,6 +7,7 @@
 
 #include "common.hpp"
 #include "gl.hpp"
+#include "gl_state.hpp"
 
 #include "texture.hpp"
 
@@ -21,6 +22,7 @@ struct framebuffer_deleter {
 
     void operator()(pointer p) const {
         auto buf = GLuint(p);
+        forget_framebuffer(buf);
         glDeleteFramebuffers(1, &buf);
     }
 };
@@ -59,7 +61,7 @@ framebuffer create_framebuffer(std::vector<texture_2d> color_texs);
 /// Sets the given framebuffer as the current.
 /// \param fb Framebuffer.
 inline void set_framebuffer(const unique_framebuffer& fb) {
-    glBindFramebuffer(GL_FRAMEBUFFER, fb.get());
+    bind_framebuffer(fb.get());
 }
 
 /// Sets the given framebuffer as the current.
@@ -70,7 +72,7 @@ inline void set_framebuffer(const framebuffer& fb) {
 
 /// Sets the default framebuffer as the current.
 inline void set_framebuffer(std::nullptr_t) {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    bind_framebuffer(0);
 }
 
 } // namespace sushi
@@ -0,0 +1,249 @@
+#include "gl_state.hpp"
+
+#include <array>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr GLuint UNKNOWN_NAME = GLuint(-1);
+constexpr GLenum UNKNOWN_ENUM = GLenum(-1);
+
+enum class tristate {
+    UNKNOWN,
+    DISABLED,
+    ENABLED
+};
+
+struct texture_unit {
+    GLuint texture_2d = UNKNOWN_NAME;
+    GLuint texture_cube_map = UNKNOWN_NAME;
+};
+
+struct shadow_state {
+    GLuint program = UNKNOWN_NAME;
+    GLuint vertex_array = UNKNOWN_NAME;
+    GLuint framebuffer = UNKNOWN_NAME;
+    int active_texture = -1;
+    std::array<texture_unit, sushi::MAX_TRACKED_TEXTURE_UNITS> units;
+    tristate blend = tristate::UNKNOWN;
+    GLenum blend_src = UNKNOWN_ENUM;
+    GLenum blend_dst = UNKNOWN_ENUM;
+    tristate depth_test = tristate::UNKNOWN;
+};
+
+shadow_state state;
+sushi::state_counters counters;
+
+/// Records a state change, returning true if it must be sent to OpenGL.
+template <typename T>
+bool update(T& cached, const T& value) {
+    if (cached == value) {
+        ++counters.saved;
+        return false;
+    }
+    cached = value;
+    ++counters.calls;
+    return true;
+}
+
+void after_change() {
+#ifdef SUSHI_VALIDATE_GL_STATE
+    sushi::validate_state();
+#endif
+}
+
+void set_capability(GLenum cap, tristate& cached, bool enabled) {
+    if (update(cached, enabled ? tristate::ENABLED : tristate::DISABLED)) {
+        if (enabled) {
+            glEnable(cap);
+        } else {
+            glDisable(cap);
+        }
+        after_change();
+    }
+}
+
+GLuint& unit_binding(texture_unit& unit, GLenum target) {
+    switch (target) {
+        case GL_TEXTURE_CUBE_MAP: return unit.texture_cube_map;
+        default: return unit.texture_2d;
+    }
+}
+
+GLint query_int(GLenum pname) {
+    GLint value = 0;
+    glGetIntegerv(pname, &value);
+    return value;
+}
+
+void check(bool ok, const std::string& what, long long cached, long long actual) {
+    if (!ok) {
+        std::ostringstream oss;
+        oss << "sushi::validate_state: Cached " << what << " is " << cached << ", but OpenGL has " << actual << ".";
+        throw std::logic_error(oss.str());
+    }
+}
+
+void check_name(GLuint cached, GLint actual, const std::string& what) {
+    check(cached == UNKNOWN_NAME || cached == GLuint(actual), what, cached, actual);
+}
+
+void check_capability(tristate cached, GLenum cap, const std::string& what) {
+    auto actual = glIsEnabled(cap) == GL_TRUE;
+    check(cached == tristate::UNKNOWN || (cached == tristate::ENABLED) == actual, what, int(cached == tristate::ENABLED), actual);
+}
+
+} // static
+
+namespace sushi {
+
+void bind_program(GLuint program) {
+    if (update(state.program, program)) {
+        glUseProgram(program);
+        after_change();
+    }
+}
+
+void bind_vertex_array(GLuint vao) {
+    if (update(state.vertex_array, vao)) {
+        glBindVertexArray(vao);
+        after_change();
+    }
+}
+
+void activate_texture_unit(int slot) {
+    if (update(state.active_texture, slot)) {
+        glActiveTexture(GL_TEXTURE0 + slot);
+        after_change();
+    }
+}
+
+void bind_texture(int slot, GLenum target, GLuint texture) {
+    if (slot < 0 || slot >= MAX_TRACKED_TEXTURE_UNITS) {
+        state.active_texture = slot;
+        glActiveTexture(GL_TEXTURE0 + slot);
+        glBindTexture(target, texture);
+        ++counters.calls;
+        return;
+    }
+
+    if (update(unit_binding(state.units[slot], target), texture)) {
+        if (state.active_texture != slot) {
+            state.active_texture = slot;
+            glActiveTexture(GL_TEXTURE0 + slot);
+        }
+        glBindTexture(target, texture);
+        after_change();
+    }
+}
+
+void bind_framebuffer(GLuint fb) {
+    if (update(state.framebuffer, fb)) {
+        glBindFramebuffer(GL_FRAMEBUFFER, fb);
+        after_change();
+    }
+}
+
+void set_blend(bool enabled) {
+    set_capability(GL_BLEND, state.blend, enabled);
+}
+
+void set_blend_func(GLenum sfactor, GLenum dfactor) {
+    if (state.blend_src == sfactor && state.blend_dst == dfactor) {
+        ++counters.saved;
+        return;
+    }
+    state.blend_src = sfactor;
+    state.blend_dst = dfactor;
+    ++counters.calls;
+    glBlendFunc(sfactor, dfactor);
+    after_change();
+}
+
+void set_depth_test(bool enabled) {
+    set_capability(GL_DEPTH_TEST, state.depth_test, enabled);
+}
+
+GLuint get_current_program() {
+    if (state.program == UNKNOWN_NAME) {
+        state.program = query_int(GL_CURRENT_PROGRAM);
+    }
+    return state.program;
+}
+
+void invalidate_state() {
+    state = shadow_state{};
+}
+
+void forget_texture(GLuint texture) {
+    for (auto& unit : state.units) {
+        if (unit.texture_2d == texture) {
+            unit.texture_2d = 0;
+        }
+        if (unit.texture_cube_map == texture) {
+            unit.texture_cube_map = 0;
+        }
+    }
+}
+
+void forget_vertex_array(GLuint vao) {
+    if (state.vertex_array == vao) {
+        state.vertex_array = 0;
+    }
+}
+
+void forget_program(GLuint program) {
+    // Deleting the current program is deferred by OpenGL until it is no longer in use,
+    // so the binding stays valid, but the name must not be trusted after it is reused.
+    if (state.program == program) {
+        state.program = UNKNOWN_NAME;
+    }
+}
+
+void forget_framebuffer(GLuint fb) {
+    if (state.framebuffer == fb) {
+        state.framebuffer = 0;
+    }
+}
+
+void validate_state() {
+    check_name(state.program, query_int(GL_CURRENT_PROGRAM), "program");
+    check_name(state.vertex_array, query_int(GL_VERTEX_ARRAY_BINDING), "vertex array");
+    check_name(state.framebuffer, query_int(GL_FRAMEBUFFER_BINDING), "framebuffer");
+
+    auto active_texture = query_int(GL_ACTIVE_TEXTURE) - GL_TEXTURE0;
+    check(state.active_texture < 0 || state.active_texture == active_texture, "active texture", state.active_texture, active_texture);
+
+    for (int i = 0; i < MAX_TRACKED_TEXTURE_UNITS; ++i) {
+        auto& unit = state.units[i];
+        if (unit.texture_2d == UNKNOWN_NAME && unit.texture_cube_map == UNKNOWN_NAME) {
+            continue;
+        }
+        glActiveTexture(GL_TEXTURE0 + i);
+        check_name(unit.texture_2d, query_int(GL_TEXTURE_BINDING_2D), "texture 2D binding of unit " + std::to_string(i));
+        check_name(unit.texture_cube_map, query_int(GL_TEXTURE_BINDING_CUBE_MAP), "cubemap binding of unit " + std::to_string(i));
+    }
+    glActiveTexture(GL_TEXTURE0 + active_texture);
+
+    check_capability(state.blend, GL_BLEND, "blend enable");
+    check_capability(state.depth_test, GL_DEPTH_TEST, "depth test enable");
+
+    if (state.blend_src != UNKNOWN_ENUM) {
+        auto src = query_int(GL_BLEND_SRC_RGB);
+        auto dst = query_int(GL_BLEND_DST_RGB);
+        check(GLenum(src) == state.blend_src, "blend source factor", state.blend_src, src);
+        check(GLenum(dst) == state.blend_dst, "blend destination factor", state.blend_dst, dst);
+    }
+}
+
+state_counters get_state_counters() {
+    return counters;
+}
+
+void reset_state_counters() {
+    counters = state_counters{};
+}
+
+} // namespace sushi
@@ -0,0 +1,98 @@
+#ifndef SUSHI_GL_STATE_HPP
+#define SUSHI_GL_STATE_HPP
+
+#include "gl.hpp"
+
+/// Sushi
+namespace sushi {
+
+/// Number of texture units tracked by the state cache.
+/// Binds to units beyond this are passed straight through to OpenGL.
+constexpr int MAX_TRACKED_TEXTURE_UNITS = 16;
+
+/// Counts the state changes that went through the state cache.
+struct state_counters {
+    /// State changes that were sent to OpenGL.
+    int calls = 0;
+
+    /// State changes that were skipped because OpenGL was already in the requested state.
+    int saved = 0;
+};
+
+/// Binds a shader program, unless it is already bound.
+/// \param program Program object name.
+void bind_program(GLuint program);
+
+/// Binds a vertex array object, unless it is already bound.
+/// \param vao Vertex array object name.
+void bind_vertex_array(GLuint vao);
+
+/// Makes a texture unit active, unless it is already active.
+/// \param slot Slot index. Must be within the range `[0,GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS)`.
+void activate_texture_unit(int slot);
+
+/// Binds a texture to a texture unit, unless it is already bound there.
+/// The active texture unit is only changed when a bind is actually needed.
+/// \param slot Slot index. Must be within the range `[0,GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS)`.
+/// \param target Either `GL_TEXTURE_2D` or `GL_TEXTURE_CUBE_MAP`.
+/// \param texture Texture object name.
+void bind_texture(int slot, GLenum target, GLuint texture);
+
+/// Binds a framebuffer to `GL_FRAMEBUFFER`, unless it is already bound.
+/// \param fb Framebuffer object name, or 0 for the default framebuffer.
+void bind_framebuffer(GLuint fb);
+
+/// Enables or disables `GL_BLEND`.
+/// \param enabled Whether blending should be enabled.
+void set_blend(bool enabled);
+
+/// Sets the blend function.
+/// \param sfactor Source factor.
+/// \param dfactor Destination factor.
+void set_blend_func(GLenum sfactor, GLenum dfactor);
+
+/// Enables or disables `GL_DEPTH_TEST`.
+/// \param enabled Whether depth testing should be enabled.
+void set_depth_test(bool enabled);
+
+/// Gets the currently bound shader program.
+/// Only queries OpenGL if the cache doesn't know the current program.
+/// \return Program object name.
+GLuint get_current_program();
+
+/// Forgets everything the cache knows about the OpenGL state.
+/// Must be called after the OpenGL state is changed without going through sushi, or after a new context is made current.
+void invalidate_state();
+
+/// Removes a deleted texture from the cache.
+/// OpenGL unbinds deleted objects implicitly, and the name may be reused by a later object.
+/// \param texture Texture object name.
+void forget_texture(GLuint texture);
+
+/// Removes a deleted vertex array object from the cache.
+/// \param vao Vertex array object name.
+void forget_vertex_array(GLuint vao);
+
+/// Removes a deleted shader program from the cache.
+/// \param program Program object name.
+void forget_program(GLuint program);
+
+/// Removes a deleted framebuffer from the cache.
+/// \param fb Framebuffer object name.
+void forget_framebuffer(GLuint fb);
+
+/// Compares the cached state against the real OpenGL state.
+/// Throws `std::logic_error` describing the first mismatch.
+/// When `SUSHI_VALIDATE_GL_STATE` is defined, this is called after every state change.
+void validate_state();
+
+/// Gets the counters accumulated since the last call to reset_state_counters().
+/// \return State counters.
+state_counters get_state_counters();
+
+/// Resets the state counters, typically once per frame.
+void reset_state_counters();
+
+} // namespace sushi
+
+#endif //SUSHI_GL_STATE_HPP
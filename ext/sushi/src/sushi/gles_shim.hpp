@@ -3,6 +3,7 @@
 
 #define GL_TEXTURE_WRAP_R GL_TEXTURE_WRAP_R_OES
 #define GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS_EXT GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS
+#define GL_VERTEX_ARRAY_BINDING GL_VERTEX_ARRAY_BINDING_OES
 
 #define glDrawBuffers glDrawBuffersEXT
 #define glGenVertexArrays glGenVertexArraysOES
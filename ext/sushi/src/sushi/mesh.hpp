@@ -7,6 +7,7 @@
 
 #include "gl.hpp"
 #include "common.hpp"
+#include "gl_state.hpp"
 #include "iqm.hpp"
 
 #include <string>
@@ -33,6 +34,7 @@ struct vertex_array_deleter {
 
     void operator()(pointer p) const {
         auto buf = GLuint(p);
+        forget_vertex_array(buf);
         glDeleteVertexArrays(1, &buf);
     }
 };
@@ -67,6 +69,14 @@ struct static_mesh {
     float bounding_sphere = 0;
 };
 
+/// A contiguous range of triangles within a static mesh.
+/// Meshes that pack many small shapes into one buffer hand out slices, so drawing them doesn't switch vertex arrays.
+struct static_mesh_slice {
+    const static_mesh* mesh = nullptr;
+    int first_triangle = 0;
+    int num_triangles = 0;
+};
+
 struct attrib_location {
     static constexpr auto POSITION = 0;
     static constexpr auto TEXCOORD = 1;
@@ -161,21 +171,26 @@ struct animated_mesh_factory {
 };
 
 /// Draws a mesh.
+/// The mesh's vertex array object is left bound, so consecutive draws of the same mesh don't rebind it.
 /// \param mesh The mesh to draw.
 inline void draw_mesh(const static_mesh& mesh) {
-    glBindVertexArray(mesh.vao.get());
-    SUSHI_DEFER { glBindVertexArray(0); };
+    bind_vertex_array(mesh.vao.get());
     glDrawArrays(GL_TRIANGLES, 0, mesh.num_triangles * 3);
 }
 
+/// Draws part of a mesh.
+/// \param slice The triangles to draw.
+inline void draw_mesh(const static_mesh_slice& slice) {
+    bind_vertex_array(slice.mesh->vao.get());
+    glDrawArrays(GL_TRIANGLES, slice.first_triangle * 3, slice.num_triangles * 3);
+}
+
 /// Draws a mesh.
 /// \param mesh The mesh to draw.
 inline void draw_mesh(const animated_mesh& mesh) {
     if (mesh.out_frames.size() > 32) throw;
-    GLint program;
-    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
-    glBindVertexArray(mesh.mesh->vao.get());
-    SUSHI_DEFER { glBindVertexArray(0); };
+    auto program = get_current_program();
+    bind_vertex_array(mesh.mesh->vao.get());
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.mesh->tris.get());
     SUSHI_DEFER { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); };
     glUniformMatrix4fv(glGetUniformLocation(program, "Bones"), mesh.out_frames.size(), GL_FALSE, (GLfloat*)&mesh.out_frames[0]);
@@ -63,13 +63,17 @@ unique_shader compile_shader_file(shader_type type, const std::string& fname) {
     }
 }
 
-unique_program link_program(const std::vector<const_reference_wrapper<unique_shader>>& shaders) {
+unique_program link_program(const std::vector<const_reference_wrapper<unique_shader>>& shaders, const std::vector<attrib_binding>& attribs) {
     unique_program rv = make_unique_program();
 
     for (const auto& shader : shaders) {
         glAttachShader(rv.get(), shader.get().get());
     }
 
+    for (const auto& attrib : attribs) {
+        glBindAttribLocation(rv.get(), attrib.location, attrib.name);
+    }
+
     glLinkProgram(rv.get());
 
     GLint log_length;
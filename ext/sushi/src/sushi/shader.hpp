@@ -8,6 +8,7 @@
 #include "common.hpp"
 
 #include "gl.hpp"
+#include "gl_state.hpp"
 
 #include <stdexcept>
 #include <string>
@@ -43,6 +44,7 @@ struct program_deleter {
 
     void operator()(pointer p) const {
         GLuint program = p;
+        forget_program(program);
         glDeleteProgram(program);
     }
 };
@@ -85,17 +87,24 @@ unique_shader compile_shader(shader_type type, std::vector<const GLchar*> code);
 /// \return A unique shader object.
 unique_shader compile_shader_file(shader_type type, const std::string& fname);
 
+/// A vertex attribute location to bind before linking.
+struct attrib_binding {
+    GLuint location;
+    const GLchar* name;
+};
+
 /// Links a shader program.
 /// \pre All of the shaders are compiled.
 /// \param shaders List of shaders to link.
+/// \param attribs Attribute locations to bind before linking. Needed where shaders can't declare their own locations.
 /// \return Unique handle to the new shader program.
-unique_program link_program(const std::vector<const_reference_wrapper<unique_shader>>& shaders);
+unique_program link_program(const std::vector<const_reference_wrapper<unique_shader>>& shaders, const std::vector<attrib_binding>& attribs = {});
 
 /// Sets the current shader program.
 /// \pre The program was successfully linked.
 /// \param program Shader program to set.
 inline void set_program(const unique_program& program) {
-    glUseProgram(program.get());
+    bind_program(program.get());
 }
 
 /// Sets a uniform in the shader program.
@@ -131,22 +140,19 @@ void set_uniform(const std::string& name, const T& data);
 
 template<>
 inline void set_uniform(const std::string& name, const glm::mat4& mat) {
-    GLint program;
-    glGetIntegerv(GL_CURRENT_PROGRAM,&program);
+    auto program = get_current_program();
     glUniformMatrix4fv(glGetUniformLocation(program, name.data()), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
 template<>
 inline void set_uniform(const std::string& name, const GLint& i) {
-    GLint program;
-    glGetIntegerv(GL_CURRENT_PROGRAM,&program);
+    auto program = get_current_program();
     glUniform1i(glGetUniformLocation(program, name.data()), i);
 }
 
 template<>
 inline void set_uniform(const std::string& name, const GLfloat& f) {
-    GLint program;
-    glGetIntegerv(GL_CURRENT_PROGRAM,&program);
+    auto program = get_current_program();
     glUniform1f(glGetUniformLocation(program, name.data()), f);
 }
 
@@ -156,8 +162,7 @@ inline void set_uniform(const std::string& name, const glm::vec2& vec) {
     for (auto i=0; i<2; ++i) {
         data[i] = vec[i];
     }
-    GLint program;
-    glGetIntegerv(GL_CURRENT_PROGRAM,&program);
+    auto program = get_current_program();
     glUniform2fv(glGetUniformLocation(program, name.data()), 1, data);
 }
 
@@ -167,8 +172,7 @@ inline void set_uniform(const std::string& name, const glm::vec3& vec) {
     for (auto i=0; i<3; ++i) {
         data[i] = vec[i];
     }
-    GLint program;
-    glGetIntegerv(GL_CURRENT_PROGRAM,&program);
+    auto program = get_current_program();
     glUniform3fv(glGetUniformLocation(program, name.data()), 1, data);
 }
 
@@ -178,8 +182,7 @@ inline void set_uniform(const std::string& name, const glm::vec4& vec) {
     for (auto i=0; i<4; ++i) {
         data[i] = vec[i];
     }
-    GLint program;
-    glGetIntegerv(GL_CURRENT_PROGRAM,&program);
+    auto program = get_current_program();
     glUniform4fv(glGetUniformLocation(program, name.data()), 1, data);
 }
 
@@ -191,15 +194,13 @@ inline void set_uniform(const std::string& name, const std::array<glm::vec3,N>&
             data[i*3+u] = vecs[i][u];
         }
     }
-    GLint program;
-    glGetIntegerv(GL_CURRENT_PROGRAM,&program);
+    auto program = get_current_program();
     glUniform3fv(glGetUniformLocation(program, name.data()), N, data);
 }
 
 template<std::size_t N>
 inline void set_uniform(const std::string& name, const float (&data)[N][3]) {
-    GLint program;
-    glGetIntegerv(GL_CURRENT_PROGRAM,&program);
+    auto program = get_current_program();
     glUniform3fv(glGetUniformLocation(program, name.data()), N, &data[0][0]);
 }
 
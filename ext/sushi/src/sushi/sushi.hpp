@@ -5,6 +5,7 @@
 #ifndef SUSHI_SUSHI_HPP
 #define SUSHI_SUSHI_HPP
 
+#include "gl_state.hpp"
 #include "mesh.hpp"
 #include "texture.hpp"
 #include "shader.hpp"
@@ -28,24 +28,28 @@ texture_2d load_texture_2d(const std::string& fname, bool smooth, bool wrap, boo
 
     auto error = lodepng::decode(image, width, height, fname);
 
-    texture_2d rv;
-
     if (error != 0) {
         std::clog << "sushi::load_texture_2d: Warning: Unable to load texture \"" << fname << "\"." << std::endl;
-        return rv;
+        return {};
     }
 
+    return create_texture_2d(&image[0], width, height, smooth, wrap, anisotropy, mipmaps, type);
+}
+
+texture_2d create_texture_2d(const unsigned char* pixels, int width, int height, bool smooth, bool wrap, bool anisotropy, bool mipmaps, TexType type) {
+    texture_2d rv;
+
     rv.handle = make_unique_texture();
     rv.width = width;
     rv.height = height;
 
-    glBindTexture(GL_TEXTURE_2D, rv.handle.get());
+    sushi::set_texture(0, rv);
 
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (smooth ? (mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR) : (mipmaps ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST)));
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (smooth ? GL_LINEAR : GL_NEAREST));
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (wrap ? GL_REPEAT : GL_CLAMP_TO_EDGE));
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, (wrap ? GL_REPEAT : GL_CLAMP_TO_EDGE));
-    glTexImage2D(GL_TEXTURE_2D, 0, GLint(type), width, height, 0, get_source_type(type), GL_UNSIGNED_BYTE, &image[0]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GLint(type), width, height, 0, get_source_type(type), GL_UNSIGNED_BYTE, pixels);
 
     if (mipmaps) {
         glGenerateMipmap(GL_TEXTURE_2D);
@@ -7,6 +7,7 @@
 
 #include "gl.hpp"
 #include "common.hpp"
+#include "gl_state.hpp"
 
 #include <string>
 
@@ -19,6 +20,7 @@ struct texture_deleter {
 
     void operator()(pointer p) const {
         auto buf = GLuint(p);
+        forget_texture(buf);
         glDeleteTextures(1, &buf);
     }
 };
@@ -60,26 +62,34 @@ enum class TexType : GLint {
 /// \return The texture represented by the file, or an empty texture if a failure occurs.
 texture_2d load_texture_2d(const std::string& fname, bool smooth, bool wrap, bool anisotropy, bool mipmaps, TexType type = TexType::COLORA);
 
+/// Creates a 2D texture from pixel data already in memory.
+/// \param pixels Pixel data, tightly packed rows in the source format of `type`.
+/// \param width Width in pixels.
+/// \param height Height in pixels.
+/// \param smooth Request texture smoothing.
+/// \param wrap Request texture wrapping.
+/// \param mipmaps Request mipmap generation.
+/// \return The new texture.
+texture_2d create_texture_2d(const unsigned char* pixels, int width, int height, bool smooth, bool wrap, bool anisotropy, bool mipmaps, TexType type = TexType::COLORA);
+
 /// Sets the active texture slot.
 /// \param slot Slot index. Must be within the range `[0,GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS)`.
 inline void set_active_texture(int slot) {
-    glActiveTexture(GL_TEXTURE0 + slot);
+    activate_texture_unit(slot);
 }
 
 /// Sets the texture for a slot.
 /// \param slot Slot index. Must be within the range `[0,GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS)`.
 /// \param tex The texture to bind.
 inline void set_texture(int slot, const texture_2d& tex) {
-    set_active_texture(slot);
-    glBindTexture(GL_TEXTURE_2D, tex.handle.get());
+    bind_texture(slot, GL_TEXTURE_2D, tex.handle.get());
 }
 
 /// Sets the texture for a slot.
 /// \param slot Slot index. Must be within the range `[0,GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS)`.
 /// \param tex The texture to bind.
 inline void set_texture(int slot, const texture_cubemap& tex) {
-    set_active_texture(slot);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, tex.handle.get());
+    bind_texture(slot, GL_TEXTURE_CUBE_MAP, tex.handle.get());
 }
 
 texture_2d create_uninitialized_texture_2d(int width, int height, TexType type = TexType::COLOR);
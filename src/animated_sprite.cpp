@@ -1,18 +1,129 @@
 #include "animated_sprite.hpp"
 
-animated_sprite::animated_sprite(const nlohmann::json& json, std::shared_ptr<sushi::texture_2d> texture) {
-    int sprite_width = json["sprite_width"];
-    int sprite_height = json["sprite_height"];
+#include "json_reader.hpp"
 
-    sprite = spritesheet(texture, sprite_width, sprite_height);
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
 
-    anims = json["anims"].get<std::map<std::string, animation>>();
+namespace {
+
+// Id 0 is the empty name, so a default animated_sprite component has a valid id.
+struct anim_names {
+    std::unordered_map<std::string, int> ids = {{"", 0}};
+    std::vector<std::string> names = {""};
+};
+
+// Function-local, so ids can be interned during static initialization.
+anim_names& get_anim_names() {
+    static anim_names names;
+    return names;
+}
+
+} //static
+
+void animation::compile() {
+    frame_ends.clear();
+    length = 0;
+    for (auto& f : frames) {
+        length += f.duration + 1;
+        frame_ends.push_back(length);
+    }
+}
+
+int animation::get_frame(int ticks) const {
+    if (loops) {
+        ticks %= length;
+        if (ticks < 0) {
+            ticks += length;
+        }
+    } else if (ticks >= length) {
+        return frames.size() - 1;
+    }
+    return std::upper_bound(frame_ends.begin(), frame_ends.end(), ticks) - frame_ends.begin();
+}
+
+int get_anim_id(const std::string& name) {
+    auto& names = get_anim_names();
+    auto iter = names.ids.find(name);
+    if (iter == end(names.ids)) {
+        iter = names.ids.emplace(name, int(names.names.size())).first;
+        names.names.push_back(name);
+    }
+    return iter->second;
+}
+
+const std::string& get_anim_name(int id) {
+    return get_anim_names().names.at(id);
+}
+
+animated_sprite_data read_animated_sprite_json(const char* begin, const char* end) {
+    animated_sprite_data data;
+
+    json_reader in (begin, end);
+    in.read_object([&](const std::string& key) {
+        if (key == "sprite_width") {
+            data.sprite_width = in.read_int();
+        } else if (key == "sprite_height") {
+            data.sprite_height = in.read_int();
+        } else if (key == "anims") {
+            in.read_object([&](const std::string& name) {
+                data.anims.emplace_back(name, animation{});
+                auto& anim = data.anims.back().second;
+                in.read_object([&](const std::string& field) {
+                    if (field == "loops") {
+                        anim.loops = in.read_bool();
+                    } else if (field == "frames") {
+                        in.read_array([&]{
+                            frame_info frame = {0, 0};
+                            int i = 0;
+                            in.read_array([&]{
+                                auto v = in.read_int();
+                                if (i == 0) frame.cell = v;
+                                else if (i == 1) frame.duration = v;
+                                ++i;
+                            });
+                            anim.frames.push_back(frame);
+                        });
+                    } else {
+                        in.skip();
+                    }
+                });
+                anim.compile();
+            });
+        } else {
+            in.skip();
+        }
+    });
+    in.finish();
+
+    return data;
+}
+
+animated_sprite::animated_sprite(const animated_sprite_data& data, texture_region region) {
+    sprite = spritesheet(std::move(region), data.sprite_width, data.sprite_height);
+
+    for (auto& named : data.anims) {
+        auto id = get_anim_id(named.first);
+        if (id >= int(anim_index.size())) {
+            anim_index.resize(id + 1, -1);
+        }
+        anim_index[id] = anims.size();
+        anims.push_back(named.second);
+    }
 }
 
 const spritesheet& animated_sprite::get_spritesheet() const {
     return sprite;
 }
 
+const animation& animated_sprite::get_anim(int id) const {
+    if (id < 0 || id >= int(anim_index.size()) || anim_index[id] < 0) {
+        throw std::out_of_range("animated_sprite: No animation named \""+get_anim_name(id)+"\".");
+    }
+    return anims[anim_index[id]];
+}
+
 const animation& animated_sprite::get_anim(const std::string& name) const {
-    return anims.at(name);
+    return get_anim(get_anim_id(name));
 }
@@ -5,9 +5,9 @@
 
 #include "json.hpp"
 
-#include <map>
 #include <vector>
 #include <string>
+#include <utility>
 
 struct frame_info {
     int cell;
@@ -24,14 +24,27 @@ inline void to_json(nlohmann::json& j, const frame_info& f) {
     j[1] = f.duration;
 }
 
+// Each frame is shown for duration+1 ticks.
 struct animation {
     bool loops;
     std::vector<frame_info> frames;
+    std::vector<int> frame_ends; // Tick at which each frame ends, a running sum of the frame lengths
+    int length; // Ticks in one play-through
+
+    void compile();
+
+    // The frame shown `ticks` after the animation started. Non-looping animations hold their last frame.
+    int get_frame(int ticks) const;
+
+    int get_cell(int ticks) const {
+        return frames[get_frame(ticks)].cell;
+    }
 };
 
 inline void from_json(const nlohmann::json& j, animation& a) {
     a.loops = j["loops"];
     a.frames = j["frames"].get<std::vector<frame_info>>();
+    a.compile();
 }
 
 inline void to_json(nlohmann::json& j, const animation& a) {
@@ -39,19 +52,40 @@ inline void to_json(nlohmann::json& j, const animation& a) {
     j["frames"] = a.frames;
 }
 
+// Animation names are interned into small ids shared by every sprite, so "idle" is the same id everywhere.
+int get_anim_id(const std::string& name);
+
+const std::string& get_anim_name(int id);
+
+// A sprite's animation file, before it's bound to a texture.
+struct animated_sprite_data {
+    int sprite_width = 0;
+    int sprite_height = 0;
+    std::vector<std::pair<std::string, animation>> anims;
+};
+
+// Streams the JSON straight into the animation tables, without building a nlohmann::json tree.
+// Throws json_reader_error if it's malformed.
+animated_sprite_data read_animated_sprite_json(const char* begin, const char* end);
+
 class animated_sprite {
 public:
     animated_sprite() = default;
 
-    animated_sprite(const nlohmann::json& json, std::shared_ptr<sushi::texture_2d> texture);
+    // Interns the animation names, so it must run on the main thread.
+    animated_sprite(const animated_sprite_data& data, texture_region region);
 
     const spritesheet& get_spritesheet() const;
 
+    // Throws std::out_of_range if the sprite doesn't have the animation.
+    const animation& get_anim(int id) const;
+
     const animation& get_anim(const std::string& name) const;
 
 private:
     spritesheet sprite;
-    std::map<std::string, animation> anims;
+    std::vector<animation> anims;
+    std::vector<int> anim_index; // Indexed by anim id, -1 if the sprite doesn't have it
 };
 
 #endif //LD40_ANIMATED_SPRITE_HPP
@@ -0,0 +1,191 @@
+#include "asset_pack.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifdef _WIN32
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char MAGIC[4] = {'L', 'D', 'P', 'K'};
+constexpr std::int32_t VERSION = 1;
+constexpr std::uint64_t ALIGNMENT = 16;
+
+struct file_header {
+    char magic[4];
+    std::int32_t version;
+    std::int32_t num_files;
+    std::int32_t strings_size;
+};
+
+struct file_entry {
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint32_t path_offset;
+    std::uint32_t path_length;
+};
+
+std::uint64_t align(std::uint64_t offset) {
+    return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+} //static
+
+asset_pack::~asset_pack() {
+    close();
+}
+
+bool asset_pack::open(const std::string& filename) {
+    close();
+
+#ifdef _WIN32
+    std::ifstream file (filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    base = buffer.data();
+    length = buffer.size();
+#else
+    auto fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    auto mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        std::clog << "asset_pack: Warning: Unable to map \"" << filename << "\"." << std::endl;
+        return false;
+    }
+
+    base = static_cast<const unsigned char*>(mapping);
+    length = st.st_size;
+#endif
+
+    file_header header;
+    if (length < sizeof(header)) {
+        close();
+        return false;
+    }
+    std::memcpy(&header, base, sizeof(header));
+
+    auto index_end = sizeof(header) + std::uint64_t(header.num_files) * sizeof(file_entry);
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.num_files < 0 || header.strings_size < 0 || index_end + header.strings_size > length) {
+        std::clog << "asset_pack: Warning: \"" << filename << "\" is not an asset pack." << std::endl;
+        close();
+        return false;
+    }
+
+    auto strings = reinterpret_cast<const char*>(base + index_end);
+
+    for (auto i = 0; i < header.num_files; ++i) {
+        file_entry entry;
+        std::memcpy(&entry, base + sizeof(header) + i * sizeof(file_entry), sizeof(entry));
+
+        if (entry.offset + entry.size > length || entry.path_offset + std::uint64_t(entry.path_length) > std::uint64_t(header.strings_size)) {
+            std::clog << "asset_pack: Warning: \"" << filename << "\" has a bad index." << std::endl;
+            close();
+            return false;
+        }
+
+        files[std::string(strings + entry.path_offset, entry.path_length)] = {base + entry.offset, std::size_t(entry.size)};
+    }
+
+    return true;
+}
+
+bool asset_pack::find(const std::string& path, asset_slice& out) const {
+    auto iter = files.find(path);
+    if (iter == end(files)) {
+        return false;
+    }
+    out = iter->second;
+    return true;
+}
+
+int asset_pack::get_num_files() const {
+    return files.size();
+}
+
+void asset_pack::close() {
+#ifdef _WIN32
+    buffer.clear();
+#else
+    if (base) {
+        munmap(const_cast<unsigned char*>(base), length);
+    }
+#endif
+    base = nullptr;
+    length = 0;
+    files.clear();
+}
+
+bool write_asset_pack(const std::string& filename, const std::string& root, const std::vector<std::string>& paths) {
+    std::vector<std::vector<char>> contents;
+    std::string strings;
+    std::vector<file_entry> entries;
+
+    for (auto& path : paths) {
+        std::ifstream file (root + "/" + path, std::ios::binary);
+        if (!file) {
+            std::clog << "write_asset_pack: Error: Unable to read \"" << path << "\"." << std::endl;
+            return false;
+        }
+        contents.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+        file_entry entry = {};
+        entry.size = contents.back().size();
+        entry.path_offset = strings.size();
+        entry.path_length = path.size();
+        entries.push_back(entry);
+        strings += path;
+    }
+
+    file_header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.num_files = entries.size();
+    header.strings_size = strings.size();
+
+    auto offset = align(sizeof(header) + entries.size() * sizeof(file_entry) + strings.size());
+    for (auto& entry : entries) {
+        entry.offset = offset;
+        offset = align(offset + entry.size);
+    }
+
+    std::ofstream file (filename, std::ios::binary);
+    if (!file) {
+        std::clog << "write_asset_pack: Error: Unable to write \"" << filename << "\"." << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(file_entry));
+    file.write(strings.data(), strings.size());
+
+    for (auto i = 0u; i < entries.size(); ++i) {
+        std::vector<char> padding (entries[i].offset - std::uint64_t(file.tellp()), 0);
+        file.write(padding.data(), padding.size());
+        file.write(contents[i].data(), contents[i].size());
+    }
+
+    return bool(file);
+}
@@ -0,0 +1,47 @@
+#ifndef LD40_ASSET_PACK_HPP
+#define LD40_ASSET_PACK_HPP
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Bytes of one file inside a pack. Points into the pack, so it lives as long as the pack does.
+struct asset_slice {
+    const unsigned char* data = nullptr;
+    std::size_t size = 0;
+};
+
+// A single archive of the files under data/, mapped into memory as a whole.
+// Binary format: header, index of {offset, size, path} records, path strings, then each file's bytes, 16-byte aligned.
+class asset_pack {
+public:
+    asset_pack() = default;
+    asset_pack(const asset_pack&) = delete;
+    asset_pack& operator=(const asset_pack&) = delete;
+    ~asset_pack();
+
+    // Returns false if the file is missing or isn't a pack.
+    bool open(const std::string& filename);
+
+    // Paths are relative to data/, with forward slashes, e.g. "textures/tiles.png".
+    // Returns false if the pack doesn't have the file.
+    bool find(const std::string& path, asset_slice& out) const;
+
+    int get_num_files() const;
+
+private:
+    void close();
+
+    const unsigned char* base = nullptr;
+    std::size_t length = 0;
+#ifdef _WIN32
+    std::vector<unsigned char> buffer;
+#endif
+    std::unordered_map<std::string, asset_slice> files;
+};
+
+// Packs the listed files, given relative to `root`, into one archive.
+bool write_asset_pack(const std::string& filename, const std::string& root, const std::vector<std::string>& paths);
+
+#endif //LD40_ASSET_PACK_HPP
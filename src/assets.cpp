@@ -0,0 +1,66 @@
+#include "assets.hpp"
+
+#include "asset_pack.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+
+namespace {
+
+const asset_pack& get_pack() {
+    static const auto pack = []{
+        auto pack = std::make_unique<asset_pack>();
+        if (pack->open("data.pak")) {
+            std::clog << "Opened data.pak: " << pack->get_num_files() << " files." << std::endl;
+        }
+        return pack;
+    }();
+    return *pack;
+}
+
+} //static
+
+namespace assets {
+
+blob::blob(const unsigned char* data, std::size_t size) : found(true), ptr(data), len(size) {}
+
+blob::blob(std::vector<unsigned char> bytes) : found(true), owned(std::move(bytes)) {
+    ptr = owned.data();
+    len = owned.size();
+}
+
+blob_istream::buffer::buffer(const blob& b) {
+    auto begin = const_cast<char*>(b.begin_chars());
+    setg(begin, begin, begin + b.size());
+}
+
+blob_istream::blob_istream(const blob& b) : std::istream(nullptr), buf(b) {
+    rdbuf(&buf);
+}
+
+blob load(const std::string& path) {
+    asset_slice slice;
+    if (get_pack().find(path, slice)) {
+        return blob(slice.data, slice.size);
+    }
+
+    std::ifstream file ("data/"+path, std::ios::binary);
+    if (!file) {
+        return {};
+    }
+
+    return blob(std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+}
+
+nlohmann::json load_json(const std::string& path) {
+    auto b = load(path);
+    if (!b) {
+        std::clog << "assets: Warning: Unable to load \"" << path << "\"." << std::endl;
+        return nullptr;
+    }
+    return nlohmann::json::parse(b.begin_chars(), b.end_chars());
+}
+
+} //namespace assets
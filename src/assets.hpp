@@ -0,0 +1,82 @@
+#ifndef LD40_ASSETS_HPP
+#define LD40_ASSETS_HPP
+
+#include "json.hpp"
+
+#include <cstddef>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace assets {
+
+// The bytes of a data file. Points straight into data.pak when the file is packed, or owns a copy read from data/.
+class blob {
+public:
+    blob() = default;
+    blob(const unsigned char* data, std::size_t size);
+    blob(std::vector<unsigned char> bytes);
+
+    // Moving keeps data() valid, but a copy would point into the original's bytes.
+    blob(blob&&) = default;
+    blob& operator=(blob&&) = default;
+    blob(const blob&) = delete;
+    blob& operator=(const blob&) = delete;
+
+    explicit operator bool() const {
+        return found;
+    }
+
+    const unsigned char* data() const {
+        return ptr;
+    }
+
+    std::size_t size() const {
+        return len;
+    }
+
+    const char* begin_chars() const {
+        return reinterpret_cast<const char*>(ptr);
+    }
+
+    const char* end_chars() const {
+        return begin_chars() + len;
+    }
+
+    // True if the blob holds its own copy, rather than pointing into data.pak.
+    bool owns_data() const {
+        return !owned.empty();
+    }
+
+private:
+    bool found = false;
+    const unsigned char* ptr = nullptr;
+    std::size_t len = 0;
+    std::vector<unsigned char> owned;
+};
+
+// Reads a blob without copying it.
+class blob_istream : public std::istream {
+public:
+    explicit blob_istream(const blob& b);
+
+private:
+    struct buffer : std::streambuf {
+        buffer(const blob& b);
+    };
+
+    buffer buf;
+};
+
+// Paths are relative to data/, e.g. "textures/tiles.png".
+// Looks in data.pak first, then falls back to the loose file, so Emscripten's preloaded data/ keeps working.
+// Safe to call from any thread. Returns an empty blob if the file doesn't exist.
+blob load(const std::string& path);
+
+// Returns null if the file doesn't exist.
+nlohmann::json load_json(const std::string& path);
+
+} //namespace assets
+
+#endif //LD40_ASSETS_HPP
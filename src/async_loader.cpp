@@ -0,0 +1,150 @@
+#include "async_loader.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// A failed load must not take down the worker or the frame loop, especially a speculative prefetch.
+// resource_cache forgets failed loads, so whoever get()s the resource later retries and sees the error.
+void run_task(const std::function<void()>& task) {
+    try {
+        task();
+    } catch (const std::exception& e) {
+        std::clog << "async_loader: Warning: Background task failed: " << e.what() << std::endl;
+    } catch (...) {
+        std::clog << "async_loader: Warning: Background task failed." << std::endl;
+    }
+}
+
+struct task_queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+
+    void push(std::function<void()> task) {
+        std::lock_guard<std::mutex> lock (mutex);
+        tasks.push_back(std::move(task));
+    }
+
+    std::size_t size() {
+        std::lock_guard<std::mutex> lock (mutex);
+        return tasks.size();
+    }
+
+    bool pop(std::function<void()>& task) {
+        std::lock_guard<std::mutex> lock (mutex);
+        if (tasks.empty()) {
+            return false;
+        }
+        task = std::move(tasks.front());
+        tasks.pop_front();
+        return true;
+    }
+};
+
+task_queue& main_queue() {
+    static task_queue queue;
+    return queue;
+}
+
+#ifndef __EMSCRIPTEN__
+class worker_pool {
+public:
+    worker_pool() {
+        auto count = std::max(1, std::min(int(std::thread::hardware_concurrency()) - 1, 4));
+        for (auto i = 0; i < count; ++i) {
+            threads.emplace_back([this]{ run(); });
+        }
+    }
+
+    ~worker_pool() {
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    void push(std::function<void()> work) {
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            jobs.push_back(std::move(work));
+        }
+        cv.notify_one();
+    }
+
+private:
+    void run() {
+        while (true) {
+            std::function<void()> work;
+            {
+                std::unique_lock<std::mutex> lock (mutex);
+                cv.wait(lock, [this]{ return stopping || !jobs.empty(); });
+                if (stopping) {
+                    return;
+                }
+                work = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            run_task(work);
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> jobs;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+};
+
+// Started on first use, so programs that never load asynchronously don't spawn threads.
+worker_pool& get_worker_pool() {
+    main_queue(); // Workers push into it, so it must be destroyed after the pool.
+    static worker_pool pool;
+    return pool;
+}
+#endif
+
+} //static
+
+namespace async_loader {
+
+void run_async(std::function<void()> work) {
+#ifdef __EMSCRIPTEN__
+    main_queue().push(std::move(work));
+#else
+    get_worker_pool().push(std::move(work));
+#endif
+}
+
+void run_on_main(std::function<void()> task) {
+    main_queue().push(std::move(task));
+}
+
+void update(std::chrono::microseconds budget) {
+    using clock = std::chrono::steady_clock;
+
+    auto deadline = clock::now() + budget;
+    auto queued = main_queue().size();
+    std::function<void()> task;
+
+    while (queued > 0 && main_queue().pop(task)) {
+        --queued;
+        run_task(task);
+        if (clock::now() >= deadline) {
+            break;
+        }
+    }
+}
+
+} //namespace async_loader
@@ -0,0 +1,22 @@
+#ifndef LD40_ASYNC_LOADER_HPP
+#define LD40_ASYNC_LOADER_HPP
+
+#include <chrono>
+#include <functional>
+
+namespace async_loader {
+
+// Runs work on a worker thread.
+// Emscripten builds have no threads, so there the work is queued for the main thread instead.
+void run_async(std::function<void()> work);
+
+// Queues a task for the main thread, usually the GPU upload that finishes a load.
+void run_on_main(std::function<void()> task);
+
+// Runs queued main-thread tasks until the budget is spent. At least one task runs, so the queue always drains.
+// Tasks queued while it runs wait for the next update, so a task that re-queues itself runs once per frame.
+void update(std::chrono::microseconds budget);
+
+} //namespace async_loader
+
+#endif //LD40_ASYNC_LOADER_HPP
@@ -0,0 +1,172 @@
+#include "buffered_stream.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr unsigned CHUNK_FRAMES = 1024;
+constexpr float DECODE_AHEAD_SECONDS = 1;
+
+} //static
+
+// A single-producer, single-consumer ring of interleaved frames.
+// The decoder thread only advances write_pos and the mixer only advances read_pos, so the mixer never locks.
+class buffered_stream_instance : public SoLoud::AudioSourceInstance {
+public:
+    buffered_stream_instance(buffered_stream& parent, bool looping) :
+        decoder(parent.stream.createInstance()),
+        channels(parent.stream.mChannels),
+        capacity(std::max(unsigned(parent.stream.mBaseSamplerate * DECODE_AHEAD_SECONDS), CHUNK_FRAMES * 2)),
+        ring(std::size_t(capacity) * channels),
+        scratch(std::size_t(CHUNK_FRAMES) * channels)
+    {
+        decoder->init(parent.stream, 0);
+        if (looping) {
+            decoder->mFlags |= SoLoud::AudioSourceInstance::LOOPING;
+        }
+
+#ifndef __EMSCRIPTEN__
+        thread = std::thread([this]{ decode_loop(); });
+#endif
+    }
+
+    ~buffered_stream_instance() override {
+#ifndef __EMSCRIPTEN__
+        stopping = true;
+        wake.notify_one();
+        thread.join();
+#endif
+    }
+
+    void getAudio(float* buffer, unsigned int samples) override {
+#ifdef __EMSCRIPTEN__
+        while (write_pos - read_pos < samples && decode_chunk()) {}
+#endif
+
+        auto r = read_pos.load(std::memory_order_relaxed);
+        auto w = write_pos.load(std::memory_order_acquire);
+        auto n = unsigned(std::min<std::size_t>(samples, w - r));
+
+        for (auto i = 0u; i < n; ++i) {
+            auto frame = &ring[((r + i) % capacity) * channels];
+            for (auto ch = 0u; ch < channels; ++ch) {
+                buffer[ch * samples + i] = frame[ch];
+            }
+        }
+
+        // An underrun plays silence rather than stalling the mixer.
+        for (auto ch = 0u; ch < channels; ++ch) {
+            std::fill(buffer + ch * samples + n, buffer + (ch + 1) * samples, 0.f);
+        }
+
+        read_pos.store(r + n, std::memory_order_release);
+        wake.notify_one();
+    }
+
+    bool hasEnded() override {
+        return decoder_ended && read_pos == write_pos;
+    }
+
+    SoLoud::result rewind() override {
+        std::lock_guard<std::mutex> lock (decoder_mutex);
+        auto result = decoder->rewind();
+        decoder_ended = false;
+        read_pos.store(write_pos.load(std::memory_order_acquire), std::memory_order_release);
+        mStreamTime = 0;
+        return result;
+    }
+
+private:
+    // Returns false if the ring is full or the decoder has ended.
+    bool decode_chunk() {
+        std::lock_guard<std::mutex> lock (decoder_mutex);
+
+        if (decoder_ended) {
+            return false;
+        }
+
+        auto w = write_pos.load(std::memory_order_relaxed);
+        auto r = read_pos.load(std::memory_order_acquire);
+        if (capacity - (w - r) < CHUNK_FRAMES) {
+            return false;
+        }
+
+        decoder->getAudio(scratch.data(), CHUNK_FRAMES);
+
+        for (auto i = 0u; i < CHUNK_FRAMES; ++i) {
+            auto frame = &ring[((w + i) % capacity) * channels];
+            for (auto ch = 0u; ch < channels; ++ch) {
+                frame[ch] = scratch[ch * CHUNK_FRAMES + i];
+            }
+        }
+
+        write_pos.store(w + CHUNK_FRAMES, std::memory_order_release);
+
+        if (decoder->hasEnded()) {
+            decoder_ended = true;
+        }
+
+        return true;
+    }
+
+    void decode_loop() {
+        while (!stopping) {
+            if (!decode_chunk()) {
+                // The mixer wakes us after each read. The timeout only covers a missed wakeup.
+                std::unique_lock<std::mutex> lock (wake_mutex);
+                wake.wait_for(lock, std::chrono::milliseconds(10));
+            }
+        }
+    }
+
+    std::unique_ptr<SoLoud::AudioSourceInstance> decoder;
+    unsigned channels;
+    std::size_t capacity; // In frames
+    std::vector<float> ring;
+    std::vector<float> scratch; // One chunk, in SoLoud's planar layout
+    std::atomic<std::size_t> read_pos {0};
+    std::atomic<std::size_t> write_pos {0};
+    std::atomic<bool> decoder_ended {false};
+    std::atomic<bool> stopping {false};
+    std::mutex decoder_mutex;
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::thread thread;
+};
+
+buffered_stream::~buffered_stream() {
+    // Instances decode from `stream`, so they must go first.
+    stop();
+}
+
+SoLoud::result buffered_stream::load(assets::blob b) {
+    stop();
+    bytes = std::move(b);
+    if (!bytes) {
+        return SoLoud::FILE_NOT_FOUND;
+    }
+
+    auto result = stream.loadMem(const_cast<unsigned char*>(bytes.data()), bytes.size(), false, false);
+    mChannels = stream.mChannels;
+    mBaseSamplerate = stream.mBaseSamplerate;
+    return result;
+}
+
+SoLoud::AudioSourceInstance* buffered_stream::createInstance() {
+    return new buffered_stream_instance(*this, (mFlags & SHOULD_LOOP) != 0);
+}
+
+SoLoud::time buffered_stream::getLength() {
+    return stream.getLength();
+}
+
+std::size_t buffered_stream::get_resident_bytes() const {
+    return bytes.owns_data() ? bytes.size() : 0;
+}
@@ -0,0 +1,39 @@
+#ifndef LD40_BUFFERED_STREAM_HPP
+#define LD40_BUFFERED_STREAM_HPP
+
+#include "assets.hpp"
+
+#include <soloud.h>
+#include <soloud_wavstream.h>
+
+#include <cstddef>
+
+class buffered_stream_instance;
+
+// Plays a compressed file by decoding it as it plays, instead of decoding all of it up front like SoLoud::Wav.
+// Each playing instance has a background thread that keeps about a second of audio decoded ahead,
+// so the mixer only copies samples and never waits on the decoder.
+// Emscripten builds have no threads, so there the mixer decodes as it goes.
+class buffered_stream : public SoLoud::AudioSource {
+public:
+    buffered_stream() = default;
+    ~buffered_stream() override;
+
+    // Keeps the file's bytes, which are read as the stream plays. Returns a SoLoud error code.
+    SoLoud::result load(assets::blob bytes);
+
+    SoLoud::AudioSourceInstance* createInstance() override;
+
+    SoLoud::time getLength();
+
+    // Bytes held for the compressed file. Packed files are mapped from data.pak, so they hold none.
+    std::size_t get_resident_bytes() const;
+
+private:
+    friend class buffered_stream_instance;
+
+    assets::blob bytes;
+    SoLoud::WavStream stream;
+};
+
+#endif //LD40_BUFFERED_STREAM_HPP
@@ -0,0 +1,117 @@
+#include "campaign.hpp"
+
+#include "assets.hpp"
+#include "async_loader.hpp"
+#include "gameplay_resources.hpp"
+#include "resources.hpp"
+
+#include <functional>
+#include <iostream>
+#include <utility>
+
+namespace campaign {
+
+namespace {
+
+// Runs `then` on the main thread once every atlas is loaded, checking once per frame.
+// Gives up if an atlas fails to load, since `then` would only retry it on the main thread.
+void when_atlases_loaded(std::vector<resource_handle> handles, std::function<void()> then) {
+    async_loader::run_on_main([handles=std::move(handles), then=std::move(then)]() mutable {
+        for (auto h : handles) {
+            if (!resources::atlases.is_loaded(h)) {
+                if (resources::atlases.is_loading(h)) {
+                    when_atlases_loaded(std::move(handles), std::move(then));
+                }
+                return;
+            }
+        }
+        then();
+    });
+}
+
+} //static
+
+const std::vector<std::string>& get_stages() {
+    static const auto stages = []{
+        std::vector<std::string> names;
+        auto json = assets::load_json("meta/campaign.json");
+        for (auto& name : json) {
+            names.push_back(name);
+        }
+        return names;
+    }();
+    return stages;
+}
+
+// What gameplay_state spawns for each part of a stage, from the names it uses.
+manifest make_manifest(const stage_data& stage) {
+    using namespace gameplay_resources;
+
+    manifest m;
+
+    // The tile sheet, player and HUD are in every stage.
+    m.spritesheets = {{TILES.name, TILES.width, TILES.height}};
+    m.atlases = {ATLAS};
+    m.animated_sprites = {PLAYER, RIGHT_FIST, LEFT_FIST, UP_FIST, DOWN_FIST};
+    m.wavs = {PUNCH_SOUND, DEATH_SOUND, WIN_SOUND};
+    m.musics = {MUSIC};
+    m.fonts = {FONT};
+
+    if (!stage.elves.empty()) {
+        m.animated_sprites.push_back(ELF);
+        m.wavs.push_back(ELF_ATTACK_SOUND);
+    }
+
+    if (!stage.beers.empty()) {
+        m.animated_sprites.push_back(BEER);
+        m.wavs.push_back(GULP_SOUND);
+    }
+
+    return m;
+}
+
+void load_async(const manifest& m) {
+    std::vector<resource_handle> atlases;
+    for (auto& name : m.atlases) {
+        atlases.push_back(resources::atlases.get_async(name).handle());
+    }
+
+    // Sprites find their textures in the atlas on the main thread, so starting them before it is loaded
+    // would decode and pack the atlas there, or block on the worker doing it.
+    when_atlases_loaded(std::move(atlases), [m]{
+        for (auto& sheet : m.spritesheets) {
+            resources::spritesheets.get_async(sheet.name, sheet.width, sheet.height);
+        }
+        for (auto& name : m.animated_sprites) {
+            resources::animated_sprites.get_async(name);
+        }
+    });
+
+    for (auto& name : m.wavs) {
+        resources::wavs.get_async(name);
+    }
+    for (auto& name : m.musics) {
+        resources::musics.get_async(name);
+    }
+    for (auto& name : m.fonts) {
+        resources::fonts.get_async(name);
+    }
+}
+
+void prefetch(int index) {
+    auto& stages = get_stages();
+    if (index < 0 || index >= int(stages.size())) {
+        return;
+    }
+
+    std::clog << "Prefetching stage: " << stages[index] << std::endl;
+
+    // The stage is read on a worker, its manifest's loads are then started from the main thread.
+    async_loader::run_async([name=stages[index]]{
+        auto stage = resources::stages.get(name);
+        auto m = make_manifest(*stage);
+        async_loader::run_on_main([m]{ load_async(m); });
+    });
+}
+
+} //namespace campaign
@@ -0,0 +1,41 @@
+#ifndef LD40_CAMPAIGN_HPP
+#define LD40_CAMPAIGN_HPP
+
+#include "stage.hpp"
+
+#include <string>
+#include <vector>
+
+namespace campaign {
+
+// Stage names in play order, from meta/campaign.json. Parsed once.
+const std::vector<std::string>& get_stages();
+
+// Every resource a stage needs, found by scanning what it spawns.
+struct manifest {
+    struct sheet {
+        std::string name;
+        int width;
+        int height;
+    };
+
+    std::vector<sheet> spritesheets;
+    std::vector<std::string> atlases;
+    std::vector<std::string> animated_sprites;
+    std::vector<std::string> wavs;
+    std::vector<std::string> musics;
+    std::vector<std::string> fonts;
+};
+
+manifest make_manifest(const stage_data& stage);
+
+// Starts loading everything in the manifest that isn't loaded or loading already. Call on the main thread.
+void load_async(const manifest& m);
+
+// Starts loading the campaign's stage at `index` and everything in its manifest in the background,
+// so a menu or the previous level can hide the load. Does nothing past the last stage.
+void prefetch(int index);
+
+} //namespace campaign
+
+#endif //LD40_CAMPAIGN_HPP
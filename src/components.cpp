@@ -1,5 +1,7 @@
 #include "components.hpp"
 
+#include "resources.hpp"
+
 namespace scripting {
 
 template <>
@@ -14,10 +16,24 @@ template <>
 void register_type<component::animated_sprite>(sol::state& lua) {
     using animated_sprite = component::animated_sprite;
     new_component_usertype<animated_sprite>(lua, "animated_sprite",
-        "name", &animated_sprite::name,
-        "anim", &animated_sprite::anim,
-        "cur_frame", &animated_sprite::cur_frame,
-        "frame_time", &animated_sprite::frame_time);
+        "name", sol::property(
+            [](const animated_sprite& self) -> std::string {
+                if (!self.sprite) {
+                    return "";
+                }
+                return std::get<0>(resources::animated_sprites.get_key(self.sprite));
+            },
+            [](animated_sprite& self, const std::string& name) {
+                self.sprite = resources::animated_sprites.intern(name);
+            }),
+        "anim", sol::property(
+            [](const animated_sprite& self) -> std::string {
+                return get_anim_name(self.anim);
+            },
+            [](animated_sprite& self, const std::string& name) {
+                self.anim = get_anim_id(name);
+            }),
+        "start_tick", &animated_sprite::start_tick);
 }
 
 } //namespace scripting
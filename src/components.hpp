@@ -4,6 +4,7 @@
 #include "json.hpp"
 #include "scripting.hpp"
 #include "entities.hpp"
+#include "resource_cache.hpp"
 
 #include <functional>
 #include <string>
@@ -17,12 +18,13 @@ struct position {
 };
 
 struct animated_sprite {
-    std::string name;
-    std::string anim;
-    int cur_frame = 0;
-    int frame_time = 0;
+    resource_handle sprite; // In resources::animated_sprites
+    int anim = 0; // From get_anim_id(), 0 is no animation
+    int start_tick = 0; // The frame is derived from the time since this, so sprites don't need updating
 };
 
+static_assert(std::is_trivially_copyable<animated_sprite>::value, "animated_sprite should be trivially copyable");
+
 struct brain{
     std::function<void(database::ent_id)> think;
 };
@@ -74,14 +74,15 @@ void editload_state::operator()() {
     {
         glClearColor(0,0,0,1);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glDisable(GL_DEPTH_TEST);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        sushi::set_depth_test(false);
+        sushi::set_blend(true);
+        sushi::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glViewport(0, 0, 640, 480);
 
         auto projmat = glm::ortho(0.f, 640.f, 0.f, 480.f, -1.f, 1.f);
 
         auto font = resources::fonts.get("LiberationSans-Regular");
-        draw_string(*font, (type==LOAD?"Load: \"":"Save: \"")+text+"\"", projmat, {0,0}, 16, text_align::LEFT);
+        prompt.set(font, (type==LOAD?"Load: \"":"Save: \"")+text+"\"", 16, text_align::LEFT);
+        prompt.draw(projmat, {0,0});
     }
 }
@@ -2,6 +2,7 @@
 #define LD40_EDITLOAD_STATE_HPP
 
 #include "tilemap.hpp"
+#include "text.hpp"
 
 #include <sushi/sushi.hpp>
 
@@ -25,6 +26,7 @@ private:
     sushi::unique_program program;
 
     std::string text;
+    text_layout prompt;
 
     editload_type type;
     editor_state* editor;
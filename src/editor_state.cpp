@@ -9,6 +9,7 @@
 #include "resources.hpp"
 #include "window.hpp"
 #include "text.hpp"
+#include "stage.hpp"
 
 #include "gameplay_state.hpp"
 #include "editload_state.hpp"
@@ -23,6 +24,20 @@
 editor_state::editor_state() {
     framebuffer = sushi::create_framebuffer(utility::vectorify(sushi::create_uninitialized_texture_2d(320, 240)));
     framebuffer_mesh = sprite_mesh(framebuffer.color_texs[0]);
+    tile_sheet = resources::spritesheets.intern("tiles", 16, 16);
+    editor_sheet = resources::spritesheets.intern("editor", 16, 16);
+    elf_sheet = resources::spritesheets.intern("elf", 16, 16);
+    beer_sheet = resources::spritesheets.intern("beer", 16, 16);
+
+    map_mesh = tilemap::tilemap_mesh(resources::spritesheets.get(tile_sheet));
+
+    auto font = resources::fonts.get("LiberationSans-Regular");
+    brush_text = text_layout(font, "Brush:", 16, text_align::LEFT);
+    for (auto line : {
+        "Arrows: Move", "Pad: Resize", "Q: Brush+", "W: Brush-", "R: Set BG", "F: Set FG", "T: Del BG", "G: Del FG",
+        "C: Wall+", "V: Wall-", "O: Elf", "P: Beer", "S: Tipsy", "]: Time+", "[: Time-", "F1: Save", "F2: Load"}) {
+        help_text.emplace_back(font, line, 16, text_align::LEFT);
+    }
 
     std::clog << "Loading basic shader..." << std::endl;
     program = sushi::link_program({
@@ -43,31 +58,33 @@ void editor_state::save(std::string name) {
 
     filename = name;
 
-    nlohmann::json json;
-    json["num_rows"] = map.get_num_rows();
-    json["num_cols"] = map.get_num_cols();
-
-    for (int r = 0; r < map.get_num_rows(); ++r) {
-        for (int c = 0; c < map.get_num_cols(); ++c) {
-            json["tiles"].push_back({map.get(r,c).flags, map.get(r,c).background, map.get(r,c).foreground});
-        }
-    }
+    stage_data stage;
+    stage.map = map;
+    stage.time_limit = time_limit;
+    stage.spawn = {int(spawn.y), int(spawn.x)};
 
     for (auto& elf : elves) {
-        json["elves"].push_back({std::get<0>(elf), std::get<1>(elf)});
+        stage.elves.push_back({std::get<0>(elf), std::get<1>(elf)});
     }
 
     for (auto& beer : beers) {
-        json["beers"].push_back({std::get<0>(beer), std::get<1>(beer)});
+        stage.beers.push_back({std::get<0>(beer), std::get<1>(beer)});
     }
 
-    json["spawn"]["r"] = int(spawn.y);
-    json["spawn"]["c"] = int(spawn.x);
-
-    json["time_limit"] = time_limit;
+    auto path = "data/stages/"+filename+".stage";
+    auto bytes = write_stage_binary(stage);
+    {
+        std::ofstream file (path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        file.close();
+        if (!file) {
+            std::clog << "editor: Warning: Unable to save stage to \"" << path << "\"." << std::endl;
+            return;
+        }
+    }
 
-    std::ofstream file ("data/stages/"+filename+".json");
-    file << json;
+    // Playing the stage later this session should see the edits.
+    resources::stages.reload(filename);
 }
 
 void editor_state::load(std::string name) {
@@ -84,28 +101,23 @@ void editor_state::load(std::string name) {
     cursor_tile = 0;
     filename = "";
 
-    std::ifstream file ("data/stages/"+name+".json");
-
-    if (file) {
-        nlohmann::json json;
-        file >> json;
+    stage_data stage;
 
-        map = tilemap::tilemap(json);
+    if (load_stage(name, stage)) {
+        map = std::move(stage.map);
 
-        if (!json["time_limit"].is_null()) {
-            time_limit = json["time_limit"];
+        if (stage.time_limit >= 0) {
+            time_limit = stage.time_limit;
         }
 
-        if (!json["spawn"].is_null()) {
-            spawn.x = json["spawn"]["c"];
-            spawn.y = json["spawn"]["r"];
-        }
+        spawn.x = stage.spawn.c;
+        spawn.y = stage.spawn.r;
 
-        for (auto& elf : json["elves"]) {
-            elves.insert({int(elf[0]),int(elf[1])});
+        for (auto& elf : stage.elves) {
+            elves.insert({elf.r, elf.c});
         }
-        for (auto& beer : json["beers"]) {
-            beers.insert({int(beer[0]),int(beer[1])});
+        for (auto& beer : stage.beers) {
+            beers.insert({beer.r, beer.c});
         }
 
         filename = name;
@@ -222,9 +234,9 @@ void editor_state::operator()() {
     {
         glClearColor(0,0,0,1);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        sushi::set_depth_test(true);
+        sushi::set_blend(true);
+        sushi::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glViewport(0, 0, 320, 240);
 
         auto projmat = glm::ortho(0.f, 320.f, 0.f, 240.f, -10.f, 10.f);
@@ -232,33 +244,29 @@ void editor_state::operator()() {
         auto cammat = glm::mat4(1.f);
         cammat = glm::translate(cammat, glm::vec3{-(position.x*16+8) + 160, -(position.y*16+8)+ 120, 0});
 
-        auto tilesheet = resources::spritesheets.get("tiles", 16, 16);
+        auto editor_sprites = resources::spritesheets.get(editor_sheet);
 
-        auto editor_sprites = resources::spritesheets.get("editor", 16, 16);
+        map_mesh.update(map);
 
-        for (auto r = 0; r < map.get_num_rows(); ++r) {
-            for (auto c = 0; c < map.get_num_cols(); ++c) {
-                auto& tile = map.get(r, c);
+        sushi::set_program(program);
+        sushi::set_uniform("cam_forward", glm::vec3{0,0,-1});
+        sushi::set_uniform("s_texture", 0);
+        sushi::set_uniform("MVP", projmat * cammat);
+        sushi::set_uniform("normal_mat", glm::mat4(1.f));
+        map_mesh.draw(tilemap::tilemap_mesh::BACKGROUND_LAYER);
+        map_mesh.draw(tilemap::tilemap_mesh::FOREGROUND_LAYER);
+
+        // Read-only access, so drawing the wall markers doesn't mark chunks as changed.
+        const auto& tiles = map;
+
+        for (auto r = 0; r < tiles.get_num_rows(); ++r) {
+            for (auto c = 0; c < tiles.get_num_cols(); ++c) {
+                auto& tile = tiles.get(r, c);
                 if (tile.flags & tilemap::BACKGROUND || tile.flags & tilemap::FOREGROUND) {
-                    auto modelmat = glm::mat4(1.f);
-                    modelmat = glm::translate(modelmat, glm::vec3{8, 8, 0});
-                    modelmat = glm::translate(modelmat, glm::vec3{c*16, r*16, 0});
-                    sushi::set_program(program);
-                    sushi::set_uniform("cam_forward", glm::vec3{0,0,-1});
-                    sushi::set_uniform("s_texture", 0);
-                    sushi::set_texture(0, tilesheet->get_texture());
-                    if (tile.flags & tilemap::BACKGROUND) {
-                        sushi::set_uniform("MVP", projmat * cammat * modelmat);
-                        sushi::set_uniform("normal_mat", glm::transpose(glm::inverse(modelmat)));
-                        sushi::draw_mesh(tilesheet->get_mesh(tile.background/16, tile.background%16));
-                    }
-                    if (tile.flags & tilemap::FOREGROUND) {
-                        auto raised_modelmat = glm::translate(modelmat, glm::vec3{0, 0, 1});
-                        sushi::set_uniform("MVP", projmat * cammat * raised_modelmat);
-                        sushi::set_uniform("normal_mat", glm::transpose(glm::inverse(cammat * raised_modelmat)));
-                        sushi::draw_mesh(tilesheet->get_mesh(tile.foreground/16, tile.foreground%16));
-                    }
                     if (tile.flags & tilemap::WALL) {
+                        auto modelmat = glm::mat4(1.f);
+                        modelmat = glm::translate(modelmat, glm::vec3{8, 8, 0});
+                        modelmat = glm::translate(modelmat, glm::vec3{c*16, r*16, 0});
                         auto raised_modelmat = glm::translate(modelmat, glm::vec3{0, 0, 2});
                         sushi::set_uniform("MVP", projmat * cammat * raised_modelmat);
                         sushi::set_uniform("normal_mat", glm::transpose(glm::inverse(cammat * raised_modelmat)));
@@ -269,7 +277,7 @@ void editor_state::operator()() {
             }
         }
 
-        auto elf_sheet = resources::spritesheets.get("elf", 16, 16);
+        auto elf_sprites = resources::spritesheets.get(elf_sheet);
 
         for (auto& elf : elves) {
             auto r = std::get<0>(elf);
@@ -282,11 +290,11 @@ void editor_state::operator()() {
             sushi::set_uniform("s_texture", 0);
             sushi::set_uniform("MVP", projmat * cammat * modelmat);
             sushi::set_uniform("normal_mat", glm::transpose(glm::inverse(modelmat)));
-            sushi::set_texture(0, elf_sheet->get_texture());
-            sushi::draw_mesh(elf_sheet->get_mesh(0,0));
+            sushi::set_texture(0, elf_sprites->get_texture());
+            sushi::draw_mesh(elf_sprites->get_mesh(0,0));
         }
 
-        auto beer_sheet = resources::spritesheets.get("beer", 16, 16);
+        auto beer_sprites = resources::spritesheets.get(beer_sheet);
 
         for (auto& beer : beers) {
             auto r = std::get<0>(beer);
@@ -299,8 +307,8 @@ void editor_state::operator()() {
             sushi::set_uniform("s_texture", 0);
             sushi::set_uniform("MVP", projmat * cammat * modelmat);
             sushi::set_uniform("normal_mat", glm::transpose(glm::inverse(modelmat)));
-            sushi::set_texture(0, beer_sheet->get_texture());
-            sushi::draw_mesh(beer_sheet->get_mesh(0,0));
+            sushi::set_texture(0, beer_sprites->get_texture());
+            sushi::draw_mesh(beer_sprites->get_mesh(0,0));
         }
 
         {
@@ -333,9 +341,9 @@ void editor_state::operator()() {
     {
         glClearColor(0,0,0,1);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glDisable(GL_DEPTH_TEST);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        sushi::set_depth_test(false);
+        sushi::set_blend(true);
+        sushi::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glViewport(0, 0, 640, 480);
 
         auto projmat = glm::ortho(-160.f, 160.f, -120.f, 120.f, -1.f, 1.f);
@@ -350,12 +358,11 @@ void editor_state::operator()() {
 
         projmat = glm::ortho(0.f, 640.f, 0.f, 480.f, -1.f, 1.f);
 
-        auto tilesheet = resources::spritesheets.get("tiles", 16, 16);
+        auto tilesheet = resources::spritesheets.get(tile_sheet);
 
-        auto editor_sprites = resources::spritesheets.get("editor", 16, 16);
+        auto editor_sprites = resources::spritesheets.get(editor_sheet);
 
-        auto font = resources::fonts.get("LiberationSans-Regular");
-        draw_string(*font, "Brush:", projmat, {0,0}, 16, text_align::LEFT);
+        brush_text.draw(projmat, {0,0});
 
         {
             auto modelmat = glm::mat4(1.f);
@@ -370,28 +377,24 @@ void editor_state::operator()() {
         }
 
         int tr = 1;
-        draw_string(*font, "Arrows: Move", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "Pad: Resize", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "Q: Brush+", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "W: Brush-", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "R: Set BG", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "F: Set FG", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "T: Del BG", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "G: Del FG", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "C: Wall+", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "V: Wall-", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "O: Elf", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "P: Beer", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "S: Tipsy", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "]: Time+", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "[: Time-", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "F1: Save", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-        draw_string(*font, "F2: Load", projmat, {0,480-16*tr++}, 16, text_align::LEFT);
-
-        auto size_str = "R,C = "+std::to_string(map.get_num_rows())+","+std::to_string(map.get_num_cols());
-        draw_string(*font, size_str, projmat, {640, 0}, 16, text_align::RIGHT);
-
-        auto time_str = "Time = " + std::to_string(time_limit);
-        draw_string(*font, time_str, projmat, {640, 480-16}, 16, text_align::RIGHT);
+        for (auto& line : help_text) {
+            line.draw(projmat, {0,480-16*tr++});
+        }
+
+        // The size and time limit only change on key presses and loads, so only then is their text laid out again.
+        if (map.get_num_rows() != size_text_rows || map.get_num_cols() != size_text_cols) {
+            size_text_rows = map.get_num_rows();
+            size_text_cols = map.get_num_cols();
+            auto size_str = "R,C = "+std::to_string(size_text_rows)+","+std::to_string(size_text_cols);
+            size_text.set(resources::fonts.get("LiberationSans-Regular"), size_str, 16, text_align::RIGHT);
+        }
+        size_text.draw(projmat, {640, 0});
+
+        if (time_limit != time_text_limit) {
+            time_text_limit = time_limit;
+            auto time_str = "Time = " + std::to_string(time_text_limit);
+            time_text.set(resources::fonts.get("LiberationSans-Regular"), time_str, 16, text_align::RIGHT);
+        }
+        time_text.draw(projmat, {640, 480-16});
     }
 }
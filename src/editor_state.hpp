@@ -2,11 +2,15 @@
 #define LD40_EDITOR_STATE_HPP
 
 #include "tilemap.hpp"
+#include "tilemap_mesh.hpp"
+#include "text.hpp"
+#include "resource_cache.hpp"
 
 #include <sushi/sushi.hpp>
 
 #include <set>
 #include <tuple>
+#include <vector>
 
 class editor_state {
 public:
@@ -22,6 +26,7 @@ public:
     glm::vec2 position = {};
     glm::vec2 spawn = {};
     tilemap::tilemap map = {1,1};
+    tilemap::tilemap_mesh map_mesh;
 
     std::set<std::tuple<int,int>> elves;
     std::set<std::tuple<int,int>> beers;
@@ -30,7 +35,20 @@ public:
 
     int cursor_tile = 0;
 
+    resource_handle tile_sheet;
+    resource_handle editor_sheet;
+    resource_handle elf_sheet;
+    resource_handle beer_sheet;
+
     std::string filename;
+
+    text_layout brush_text;
+    std::vector<text_layout> help_text;
+    int size_text_rows = -1;
+    int size_text_cols = -1;
+    text_layout size_text;
+    int time_text_limit = -1;
+    text_layout time_text;
 };
 
 #endif //LD40_EDITOR_STATE_HPP
@@ -1,6 +1,8 @@
 #include "font.hpp"
 
+#include "assets.hpp"
 #include "json.hpp"
+#include "utility.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -10,6 +12,13 @@
 
 namespace {
 
+// Runs are only cached for strings that are drawn repeatedly, so the cache is simply dropped when it grows past this.
+constexpr std::size_t MAX_CACHED_RUNS = 256;
+
+std::uint64_t kerning_key(int left, int right) {
+    return (std::uint64_t(std::uint32_t(left)) << 32) | std::uint32_t(right);
+}
+
 msdfgen::FreetypeHandle* font_init() {
     static const auto ft = msdfgen::initializeFreetype();
     return ft;
@@ -17,18 +26,14 @@ msdfgen::FreetypeHandle* font_init() {
 
 #ifdef __EMSCRIPTEN__
 const auto vertexSource_msdf = R"(
-    attribute vec3 position;
+    attribute vec2 position;
     attribute vec2 texcoord;
-    attribute vec3 normal;
     varying vec2 v_texcoord;
-    varying vec3 v_normal;
     uniform mat4 MVP;
-    uniform mat4 normal_mat;
     void main()
     {
         v_texcoord = texcoord;
-        v_normal = vec3(normal_mat * vec4(normal, 0.0));
-        gl_Position = MVP * vec4(position, 1.0);
+        gl_Position = MVP * vec4(position, 0.0, 1.0);
     }
 )";
 
@@ -37,7 +42,6 @@ const auto fragmentSource_msdf = R"(
 
     precision mediump float;
     varying vec2 v_texcoord;
-    varying vec3 v_normal;
     uniform sampler2D msdf;
     uniform float pxRange;
     uniform vec2 texSize;
@@ -58,24 +62,19 @@ const auto fragmentSource_msdf = R"(
 )";
 #else
 const auto vertexSource_msdf = R"(#version 400
-    layout(location = 0) in vec3 position;
+    layout(location = 0) in vec2 position;
     layout(location = 1) in vec2 texcoord;
-    layout(location = 2) in vec3 normal;
     out vec2 v_texcoord;
-    out vec3 v_normal;
     uniform mat4 MVP;
-    uniform mat4 normal_mat;
     void main()
     {
         v_texcoord = texcoord;
-        v_normal = vec3(normal_mat * vec4(normal, 0.0));
-        gl_Position = MVP * vec4(position, 1.0);
+        gl_Position = MVP * vec4(position, 0.0, 1.0);
     }
 )";
 
 const auto fragmentSource_msdf = R"(#version 400
     in vec2 v_texcoord;
-    in vec3 v_normal;
     uniform sampler2D msdf;
     uniform float pxRange;
     uniform vec2 texSize;
@@ -99,28 +98,53 @@ const auto fragmentSource_msdf = R"(#version 400
 
 } //static
 
-msdf_font::msdf_font(const std::string& fontname) {
-    auto ft = font_init();
+constexpr int msdf_font::PAGE_SIZE;
 
-    if (!ft) {
-        throw std::runtime_error("Failed to initialize FreeType.");
-    }
+msdf_font::msdf_font(const std::string& fontname) : fontname(fontname) {
+    baked_font baked;
 
-    font = decltype(font)(msdfgen::loadFont(ft, ("data/fonts/"+fontname+".ttf").c_str()));
+    auto bytes = assets::load("fonts/"+fontname+".msdf");
+    assets::blob_istream file (bytes);
 
-    if (!font) {
-        throw std::runtime_error("Failed to load font "+fontname+".");
+    if (bytes && load_baked_font(file, fontname, baked)) {
+        if (baked.page_size == PAGE_SIZE) {
+            for (auto& pixels : baked.pages) {
+                atlas_page p;
+                p.texture = sushi::create_texture_2d(&pixels[0], PAGE_SIZE, PAGE_SIZE, true, false, false, false);
+                pages.push_back(std::move(p));
+            }
+
+            for (auto& bg : baked.glyphs) {
+                auto g = glyph{};
+                g.page = bg.page;
+                g.rect = bg.rect;
+                g.uv = glm::vec4{bg.x, bg.y, bg.x + bg.width, bg.y + bg.height} / float(PAGE_SIZE);
+                g.advance = bg.advance;
+                g.baked = true;
+                glyphs.emplace(bg.unicode, g);
+            }
+
+            for (auto& bk : baked.kerning) {
+                kerning.emplace(kerning_key(bk.left, bk.right), bk.amount);
+            }
+
+            std::clog << "Loaded " << glyphs.size() << " baked glyphs for font " << fontname << "." << std::endl;
+        } else {
+            std::clog << "msdf_font: Warning: Baked font " << fontname << " has the wrong page size." << std::endl;
+        }
+    }
+
+    if (glyphs.empty()) {
+        get_font_handle();
     }
 
     program = sushi::link_program({
         sushi::compile_shader(sushi::shader_type::VERTEX, {vertexSource_msdf}),
         sushi::compile_shader(sushi::shader_type::FRAGMENT, {fragmentSource_msdf}),
+    }, {
+        {sushi::attrib_location::POSITION, "position"},
+        {sushi::attrib_location::TEXCOORD, "texcoord"},
     });
-
-    sushi::set_program(program);
-    glBindAttribLocation(program.get(), sushi::attrib_location::POSITION, "position");
-    glBindAttribLocation(program.get(), sushi::attrib_location::TEXCOORD, "texcoord");
-    glBindAttribLocation(program.get(), sushi::attrib_location::NORMAL, "normal");
 }
 
 void msdf_font::bind_shader() const {
@@ -128,80 +152,127 @@ void msdf_font::bind_shader() const {
     sushi::set_uniform("msdf", 0);
     sushi::set_uniform("pxRange", 4.f);
     sushi::set_uniform("fgColor", glm::vec4{1,1,1,1});
+    sushi::set_uniform("texSize", glm::vec2{PAGE_SIZE, PAGE_SIZE});
 }
 
 const msdf_font::glyph& msdf_font::get_glyph(int unicode) {
     auto iter = glyphs.find(unicode);
 
     if (iter == end(glyphs)) {
-        msdfgen::Shape shape;
-        double advance;
+        msdf_glyph_bitmap bitmap;
 
-        if (!msdfgen::loadGlyph(shape, font.get(), unicode, &advance)) {
-            return glyphs.at(0);
+        if (!generate_msdf_glyph(get_font_handle(), unicode, bitmap)) {
+            // Cache the fallback under the missing code point so the font isn't asked again.
+            auto fallback = unicode == '?' ? glyph{} : get_glyph('?');
+            fallback.baked = false;
+            return glyphs.emplace(unicode, fallback).first->second;
         }
 
-        shape.normalize();
-        msdfgen::edgeColoringSimple(shape, 3.0);
-
-        double left=0, bottom=0, right=0, top=0;
-        shape.bounds(left, bottom, right, top);
+        auto width = bitmap.width;
+        auto height = bitmap.height;
 
-        left -= 1;
-        bottom -= 1;
-        right += 1;
-        top += 1;
-
-        auto width = int(right - left + 1);
-        auto height = int(top - bottom + 1);
-
-        msdfgen::Bitmap<msdfgen::FloatRGB> msdf(width, height);
-        msdfgen::generateMSDF(msdf, shape, 4.0, 1.0, msdfgen::Vector2(-left, -bottom));
+        // Leave a texel of empty border so linear filtering never samples a neighbor.
+        int x, y;
+        auto page = 0;
+        while (page < int(pages.size()) && !pages[page].packer.pack(width + 2, height + 2, x, y)) {
+            ++page;
+        }
 
-        std::vector<unsigned char> pixels;
-        pixels.reserve(4*msdf.width()*msdf.height());
-        for (int y = 0; y < msdf.height(); ++y) {
-            for (int x = 0; x < msdf.width(); ++x) {
-                pixels.push_back(msdfgen::clamp(int(msdf(x, y).r*0x100), 0xff));
-                pixels.push_back(msdfgen::clamp(int(msdf(x, y).g*0x100), 0xff));
-                pixels.push_back(msdfgen::clamp(int(msdf(x, y).b*0x100), 0xff));
-                pixels.push_back(255);
+        if (page == int(pages.size())) {
+            std::vector<unsigned char> empty (PAGE_SIZE * PAGE_SIZE * 4, 0);
+            atlas_page p;
+            p.texture = sushi::create_texture_2d(&empty[0], PAGE_SIZE, PAGE_SIZE, true, false, false, false);
+            p.packer = skyline_packer(PAGE_SIZE, PAGE_SIZE);
+            if (!p.packer.pack(width + 2, height + 2, x, y)) {
+                throw std::runtime_error("Glyph "+std::to_string(unicode)+" is too large for the font atlas.");
             }
+            pages.push_back(std::move(p));
         }
 
-        double em;
-        msdfgen::getFontScale(em, font.get());
+        x += 1;
+        y += 1;
 
-        left /= em;
-        right /= em;
-        bottom /= em;
-        top /= em;
-        advance /= em;
+        sushi::set_texture(0, pages[page].texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &bitmap.pixels[0]);
 
         auto g = glyph{};
 
-        g.mesh = sushi::load_static_mesh_data(
-            {{left, bottom, 0.f},{left, top, 0.f},{right, top, 0.f},{right, bottom, 0.f}},
-            {{0.f, 0.f, 1.f},{0.f, 0.f, 1.f},{0.f, 0.f, 1.f},{0.f, 0.f, 1.f}},
-            {{0.f, 0.f},{0.f, 1.f},{1.f, 1.f},{1.f, 0.f}},
-            {{{{0,0,0},{1,1,1},{2,2,2}}},{{{2,2,2},{3,3,3},{0,0,0}}}});
+        g.page = page;
+        g.rect = bitmap.rect;
+        g.uv = glm::vec4{x, y, x + width, y + height} / float(PAGE_SIZE);
+        g.advance = bitmap.advance;
 
-        g.texture.handle = sushi::make_unique_texture();
-        g.texture.width = width;
-        g.texture.height = height;
+        iter = glyphs.emplace(unicode, std::move(g)).first;
+    }
 
-        glBindTexture(GL_TEXTURE_2D, g.texture.handle.get());
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, msdf.width(), msdf.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+    return iter->second;
+}
 
-        g.advance = advance;
+float msdf_font::get_kerning(int left, int right) {
+    auto key = kerning_key(left, right);
+    auto iter = kerning.find(key);
 
-        iter = glyphs.emplace(unicode, std::move(g)).first;
+    if (iter != end(kerning)) {
+        return iter->second;
     }
 
-    return iter->second;
+    // The baked table lists every nonzero pair of baked glyphs.
+    if (get_glyph(left).baked && get_glyph(right).baked) {
+        return 0;
+    }
+
+    auto amount = get_msdf_kerning(get_font_handle(), left, right);
+    kerning.emplace(key, amount);
+    return amount;
+}
+
+const msdf_font::glyph_run& msdf_font::get_run(const std::string& utf8) {
+    auto iter = runs.find(utf8);
+
+    if (iter != end(runs)) {
+        return iter->second;
+    }
+
+    if (runs.size() >= MAX_CACHED_RUNS) {
+        runs.clear();
+    }
+
+    glyph_run run;
+
+    utility::decode_utf8(utf8, codepoints);
+    run.glyphs.reserve(codepoints.size());
+
+    for (auto i = 0u; i < codepoints.size(); ++i) {
+        if (i > 0) {
+            run.advance += get_kerning(codepoints[i - 1], codepoints[i]);
+        }
+        auto& g = get_glyph(codepoints[i]);
+        run.glyphs.push_back({&g, run.advance});
+        run.advance += g.advance;
+    }
+
+    return runs.emplace(utf8, std::move(run)).first->second;
+}
+
+msdfgen::FontHandle* msdf_font::get_font_handle() {
+    if (!font) {
+        auto ft = font_init();
+
+        if (!ft) {
+            throw std::runtime_error("Failed to initialize FreeType.");
+        }
+
+        font = decltype(font)(msdfgen::loadFont(ft, ("data/fonts/"+fontname+".ttf").c_str()));
+
+        if (!font) {
+            throw std::runtime_error("Failed to load font "+fontname+".");
+        }
+    }
+
+    return font.get();
+}
+
+const sushi::texture_2d& msdf_font::get_page(int page) const {
+    return pages[page].texture;
 }
 
@@ -1,6 +1,9 @@
 #ifndef LD40_FONT_HPP
 #define LD40_FONT_HPP
 
+#include "font_bake.hpp"
+#include "skyline_packer.hpp"
+
 #include <sushi/mesh.hpp>
 #include <sushi/shader.hpp>
 #include <sushi/texture.hpp>
@@ -8,9 +11,11 @@
 #include <msdfgen.h>
 #include <msdfgen-ext.h>
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <memory>
+#include <vector>
 
 struct FontDeleter {
     void operator()(msdfgen::FontHandle* ptr) {
@@ -18,23 +23,67 @@ struct FontDeleter {
     }
 };
 
+// Glyphs come from the baked atlas in data/fonts/<name>.msdf when there is one.
+// Anything else is generated on first use and packed into shared atlas pages.
+// Code points the font doesn't have are drawn as '?'.
 class msdf_font {
 public:
     struct glyph {
-        sushi::static_mesh mesh;
-        sushi::texture_2d texture;
-        float advance;
+        int page = -1; // -1 if there's nothing to draw
+        glm::vec4 rect{}; // {left, bottom, right, top} in ems
+        glm::vec4 uv{}; // Texture coordinates of the rect's corners, same layout
+        float advance = 0;
+        bool baked = false;
+    };
+
+    struct placed_glyph {
+        const glyph* g;
+        float x; // Pen position in ems
+    };
+
+    // A shaped UTF-8 string: glyphs with kerning applied, and the total advance in ems.
+    struct glyph_run {
+        std::vector<placed_glyph> glyphs;
+        float advance = 0;
+    };
+
+    struct vertex {
+        glm::vec2 position;
+        glm::vec2 texcoord;
     };
 
+    static constexpr int PAGE_SIZE = MSDF_PAGE_SIZE;
+
     msdf_font() = default;
     msdf_font(const std::string& filename);
 
     void bind_shader() const;
     const glyph& get_glyph(int unicode);
 
+    // Kerning between two code points, in ems.
+    float get_kerning(int left, int right);
+
+    // Shapes a UTF-8 string. The run is cached, and stays valid until the next call.
+    const glyph_run& get_run(const std::string& utf8);
+
+    const sushi::texture_2d& get_page(int page) const;
+
 private:
+    struct atlas_page {
+        sushi::texture_2d texture;
+        skyline_packer packer; // Baked pages are never added to, so theirs stays empty.
+    };
+
+    // Loads FreeType and the font file the first time a glyph has to be generated.
+    msdfgen::FontHandle* get_font_handle();
+
+    std::string fontname;
     std::unique_ptr<msdfgen::FontHandle, FontDeleter> font;
     std::unordered_map<int, glyph> glyphs;
+    std::unordered_map<std::uint64_t, float> kerning;
+    std::unordered_map<std::string, glyph_run> runs;
+    std::vector<int> codepoints;
+    std::vector<atlas_page> pages;
     sushi::unique_program program;
 };
 
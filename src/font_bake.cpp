@@ -0,0 +1,247 @@
+#include "font_bake.hpp"
+
+#include "skyline_packer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+constexpr char MAGIC[4] = {'L','D','F','N'};
+constexpr std::int32_t VERSION = 2;
+
+struct file_header {
+    char magic[4];
+    std::int32_t version;
+    std::int32_t page_size;
+    std::int32_t num_pages;
+    std::int32_t num_glyphs;
+    std::int32_t num_kerning;
+};
+
+struct file_glyph {
+    std::int32_t unicode;
+    std::int32_t page;
+    std::int32_t x;
+    std::int32_t y;
+    std::int32_t width;
+    std::int32_t height;
+    float rect[4];
+    float advance;
+};
+
+struct file_kerning {
+    std::int32_t left;
+    std::int32_t right;
+    float amount;
+};
+
+template <typename T>
+bool read_pod(std::istream& in, T& value) {
+    return bool(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template <typename T>
+void write_pod(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} //static
+
+bool generate_msdf_glyph(msdfgen::FontHandle* font, int unicode, msdf_glyph_bitmap& out) {
+    msdfgen::Shape shape;
+    double advance;
+
+    if (!msdfgen::loadGlyph(shape, font, unicode, &advance)) {
+        return false;
+    }
+
+    shape.normalize();
+    msdfgen::edgeColoringSimple(shape, 3.0);
+
+    double left=0, bottom=0, right=0, top=0;
+    shape.bounds(left, bottom, right, top);
+
+    left -= 1;
+    bottom -= 1;
+    right += 1;
+    top += 1;
+
+    auto width = int(right - left + 1);
+    auto height = int(top - bottom + 1);
+
+    out.pixels.resize(4*width*height);
+    msdfgen::generateMSDF_RGBA8(&out.pixels[0], width, height, shape, 4.0, 1.0, msdfgen::Vector2(-left, -bottom));
+
+    double em;
+    msdfgen::getFontScale(em, font);
+
+    out.width = width;
+    out.height = height;
+    out.rect = glm::vec4{left / em, bottom / em, right / em, top / em};
+    out.advance = advance / em;
+
+    return true;
+}
+
+float get_msdf_kerning(msdfgen::FontHandle* font, int left, int right) {
+    double kerning;
+    double em;
+    if (!msdfgen::getKerning(kerning, font, left, right) || !msdfgen::getFontScale(em, font)) {
+        return 0;
+    }
+    return kerning / em;
+}
+
+baked_font bake_font(msdfgen::FontHandle* font, const std::vector<int>& charset, int page_size) {
+    baked_font rv;
+    rv.page_size = page_size;
+
+    std::vector<skyline_packer> packers;
+    msdf_glyph_bitmap bitmap;
+
+    for (auto unicode : charset) {
+        if (!generate_msdf_glyph(font, unicode, bitmap)) {
+            std::clog << "bake_font: Warning: Font has no glyph " << unicode << "." << std::endl;
+            continue;
+        }
+
+        // Same one-texel empty border as glyphs generated at runtime.
+        int x, y;
+        auto page = 0;
+        while (page < int(packers.size()) && !packers[page].pack(bitmap.width + 2, bitmap.height + 2, x, y)) {
+            ++page;
+        }
+
+        if (page == int(packers.size())) {
+            packers.emplace_back(page_size, page_size);
+            rv.pages.emplace_back(page_size * page_size * 4, 0);
+            if (!packers.back().pack(bitmap.width + 2, bitmap.height + 2, x, y)) {
+                std::clog << "bake_font: Warning: Glyph " << unicode << " is too large for the page." << std::endl;
+                packers.pop_back();
+                rv.pages.pop_back();
+                continue;
+            }
+        }
+
+        x += 1;
+        y += 1;
+
+        auto& pixels = rv.pages[page];
+        for (auto row = 0; row < bitmap.height; ++row) {
+            std::memcpy(&pixels[((y + row) * page_size + x) * 4], &bitmap.pixels[row * bitmap.width * 4], bitmap.width * 4);
+        }
+
+        rv.glyphs.push_back({unicode, page, x, y, bitmap.width, bitmap.height, bitmap.rect, bitmap.advance});
+    }
+
+    for (const auto& left : rv.glyphs) {
+        for (const auto& right : rv.glyphs) {
+            auto amount = get_msdf_kerning(font, left.unicode, right.unicode);
+            if (amount != 0) {
+                rv.kerning.push_back({left.unicode, right.unicode, amount});
+            }
+        }
+    }
+
+    return rv;
+}
+
+bool load_baked_font(const std::string& filename, baked_font& out) {
+    std::ifstream file (filename, std::ios::binary);
+
+    if (!file) {
+        return false;
+    }
+
+    return load_baked_font(file, filename, out);
+}
+
+bool load_baked_font(std::istream& file, const std::string& filename, baked_font& out) {
+    file_header header;
+    if (!read_pod(file, header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.page_size <= 0 || header.page_size > 8192 || header.num_pages < 0 || header.num_glyphs < 0 || header.num_kerning < 0) {
+        std::clog << "load_baked_font: Warning: \"" << filename << "\" is not a baked font." << std::endl;
+        return false;
+    }
+
+    out.page_size = header.page_size;
+    out.glyphs.clear();
+    out.glyphs.reserve(header.num_glyphs);
+
+    for (auto i = 0; i < header.num_glyphs; ++i) {
+        file_glyph fg;
+        if (!read_pod(file, fg) || fg.page < 0 || fg.page >= header.num_pages) {
+            std::clog << "load_baked_font: Warning: \"" << filename << "\" has a bad glyph table." << std::endl;
+            return false;
+        }
+        out.glyphs.push_back({fg.unicode, fg.page, fg.x, fg.y, fg.width, fg.height,
+            glm::vec4{fg.rect[0], fg.rect[1], fg.rect[2], fg.rect[3]}, fg.advance});
+    }
+
+    out.kerning.clear();
+    out.kerning.reserve(header.num_kerning);
+
+    for (auto i = 0; i < header.num_kerning; ++i) {
+        file_kerning fk;
+        if (!read_pod(file, fk)) {
+            std::clog << "load_baked_font: Warning: \"" << filename << "\" has a bad kerning table." << std::endl;
+            return false;
+        }
+        out.kerning.push_back({fk.left, fk.right, fk.amount});
+    }
+
+    out.pages.assign(header.num_pages, std::vector<unsigned char>(header.page_size * header.page_size * 4, 0));
+
+    for (auto& page : out.pages) {
+        std::int32_t rows;
+        if (!read_pod(file, rows) || rows < 0 || rows > header.page_size ||
+            !file.read(reinterpret_cast<char*>(&page[0]), rows * header.page_size * 4)) {
+            std::clog << "load_baked_font: Warning: \"" << filename << "\" is truncated." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool save_baked_font(const std::string& filename, const baked_font& font) {
+    std::ofstream file (filename, std::ios::binary);
+
+    file_header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.page_size = font.page_size;
+    header.num_pages = font.pages.size();
+    header.num_glyphs = font.glyphs.size();
+    header.num_kerning = font.kerning.size();
+    write_pod(file, header);
+
+    for (const auto& g : font.glyphs) {
+        file_glyph fg = {g.unicode, g.page, g.x, g.y, g.width, g.height, {g.rect.x, g.rect.y, g.rect.z, g.rect.w}, g.advance};
+        write_pod(file, fg);
+    }
+
+    for (const auto& k : font.kerning) {
+        file_kerning fk = {k.left, k.right, k.amount};
+        write_pod(file, fk);
+    }
+
+    // Pages fill from the bottom, so the empty rows at the top are left out.
+    for (auto i = 0; i < int(font.pages.size()); ++i) {
+        std::int32_t rows = 0;
+        for (const auto& g : font.glyphs) {
+            if (g.page == i) {
+                rows = std::max(rows, std::int32_t(g.y + g.height + 1));
+            }
+        }
+        rows = std::min(rows, std::int32_t(font.page_size));
+        write_pod(file, rows);
+        file.write(reinterpret_cast<const char*>(&font.pages[i][0]), rows * font.page_size * 4);
+    }
+
+    return bool(file);
+}
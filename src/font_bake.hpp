@@ -0,0 +1,70 @@
+#ifndef LD40_FONT_BAKE_HPP
+#define LD40_FONT_BAKE_HPP
+
+#include <msdfgen.h>
+#include <msdfgen-ext.h>
+
+#include <glm/glm.hpp>
+
+#include <istream>
+#include <string>
+#include <vector>
+
+// Shared by the font baker and msdf_font, so baked and live glyphs agree.
+constexpr int MSDF_PAGE_SIZE = 512;
+
+// The MSDF bitmap and metrics of one glyph.
+struct msdf_glyph_bitmap {
+    std::vector<unsigned char> pixels; // RGBA, bottom row first
+    int width = 0;
+    int height = 0;
+    glm::vec4 rect; // {left, bottom, right, top} in ems
+    float advance = 0;
+};
+
+// Returns false if the font has no such glyph.
+bool generate_msdf_glyph(msdfgen::FontHandle* font, int unicode, msdf_glyph_bitmap& out);
+
+// A glyph placed in a baked atlas page. The texel rect excludes the glyph's empty border.
+struct baked_glyph {
+    int unicode;
+    int page;
+    int x;
+    int y;
+    int width;
+    int height;
+    glm::vec4 rect;
+    float advance;
+};
+
+// Kerning between two baked glyphs, in ems. Pairs that aren't listed have none.
+struct baked_kerning {
+    int left;
+    int right;
+    float amount;
+};
+
+// Atlas pages and metrics of a pre-generated character set.
+struct baked_font {
+    int page_size = 0;
+    std::vector<std::vector<unsigned char>> pages; // RGBA, page_size*page_size
+    std::vector<baked_glyph> glyphs;
+    std::vector<baked_kerning> kerning;
+};
+
+// Kerning between two code points, in ems.
+float get_msdf_kerning(msdfgen::FontHandle* font, int left, int right);
+
+// Generates and packs the glyphs of the charset, skipping any the font doesn't have, and records their kerning pairs.
+baked_font bake_font(msdfgen::FontHandle* font, const std::vector<int>& charset, int page_size);
+
+// Binary format: header, glyph table, kerning table, then each page's row count and raw pixels. Rows past the count are empty.
+// Returns false if the file is missing or malformed.
+bool load_baked_font(const std::string& filename, baked_font& out);
+
+// `name` is only used in warnings.
+bool load_baked_font(std::istream& file, const std::string& name, baked_font& out);
+
+bool save_baked_font(const std::string& filename, const baked_font& font);
+
+#endif //LD40_FONT_BAKE_HPP
@@ -0,0 +1,44 @@
+#ifndef LD40_GAMEPLAY_RESOURCES_HPP
+#define LD40_GAMEPLAY_RESOURCES_HPP
+
+// Every resource gameplay_state uses, named once.
+// gameplay_state loads, interns and plays resources by these names, and campaign::make_manifest() lists them,
+// so a stage's manifest can't miss anything the stage spawns.
+namespace gameplay_resources {
+
+struct sheet {
+    const char* name;
+    int width;
+    int height;
+};
+
+// In every stage
+
+constexpr sheet TILES = {"tiles", 16, 16};
+constexpr auto ATLAS = "atlas"; // Holds the animated sprites' textures
+constexpr auto MUSIC = "TipsysTunes";
+constexpr auto FONT = "LiberationSans-Regular";
+
+constexpr auto PLAYER = "tipsy";
+constexpr auto RIGHT_FIST = "rightfist";
+constexpr auto LEFT_FIST = "leftfist";
+constexpr auto UP_FIST = "upfist";
+constexpr auto DOWN_FIST = "downfist";
+
+constexpr auto PUNCH_SOUND = "punch";
+constexpr auto DEATH_SOUND = "death";
+constexpr auto WIN_SOUND = "win";
+
+// Only in stages with elves
+
+constexpr auto ELF = "elf";
+constexpr auto ELF_ATTACK_SOUND = "elfattack";
+
+// Only in stages with beers
+
+constexpr auto BEER = "beer";
+constexpr auto GULP_SOUND = "gulp";
+
+} //namespace gameplay_resources
+
+#endif //LD40_GAMEPLAY_RESOURCES_HPP
@@ -1,71 +1,88 @@
 #include "gameplay_state.hpp"
 
 #include "resources.hpp"
+#include "campaign.hpp"
+#include "gameplay_resources.hpp"
 #include "basic_shader.hpp"
 #include "components.hpp"
 #include "sdl.hpp"
 #include "utility.hpp"
 #include "sprite.hpp"
+#include "sprite_batch.hpp"
 #include "platform.hpp"
 #include "random.hpp"
 #include "window.hpp"
 #include "mainloop.hpp"
 #include "text.hpp"
+#include "timeline.hpp"
 #include "soloud.hpp"
+#include "sfx.hpp"
 
 #include "end_state.hpp"
 
+namespace {
+
+const auto idle_anim = get_anim_id("idle");
+const auto left_anim = get_anim_id("left");
+
+} //static
+
 gameplay_state::gameplay_state(int s){
     stage = s;
 }
 
 bool gameplay_state::init() {
+    timeline::phases level_load ("level load");
 
-    std::ifstream campaignjson ("data/meta/campaign.json");
-    nlohmann::json json;
-    campaignjson >> json;
+    auto& stages = campaign::get_stages();
 
-    if (stage < json.size()) {
+    if (stage < int(stages.size())) {
         std::clog << "Loading stage #" << stage << std::endl;
-        levelname = json[stage];
+        levelname = stages[stage];
     } else {
         std::clog << "Winner" << std::endl;
         mainloop::states.pop_back();
         mainloop::states.push_back(end_state("win"));
-        g_soloud->stopAll();
-        g_soloud->play(*resources::wavs.get("win"));
+        sfx::stop_all();
+        sfx::play(gameplay_resources::WIN_SOUND);
         return false;
     }
 
-    auto music = resources::musics.get("TipsysTunes");
+    level_load.next("music");
+    auto music = resources::musics.get(gameplay_resources::MUSIC);
     g_soloud->stopAudioSource(*music);
     g_soloud->play(*music);
 
+    level_load.next("stage");
     std::clog << "Loading stage..." << std::endl;
-    std::ifstream test_stage_file ("data/stages/" + levelname + ".json");
-    nlohmann::json test_stage_json;
-    test_stage_file >> test_stage_json;
-    test_stage_file.close();
-    test_stage = tilemap::tilemap(test_stage_json);
-
-    if (!test_stage_json["time_limit"].is_null()) {
-        rem_time = int(test_stage_json["time_limit"]) * 60;
+    auto stage_ptr = resources::stages.get(levelname);
+    auto& stage_info = *stage_ptr;
+
+    // Usually prefetched by the menu or the previous stage already. Anything still missing loads in the background,
+    // so resources first needed mid-game don't hitch.
+    campaign::load_async(campaign::make_manifest(stage_info));
+
+    test_stage = stage_info.map;
+    auto& tiles = gameplay_resources::TILES;
+    test_stage_mesh = tilemap::tilemap_mesh(resources::spritesheets.get(tiles.name, tiles.width, tiles.height));
+
+    if (stage_info.time_limit >= 0) {
+        rem_time = stage_info.time_limit * 60;
     } else {
         rem_time = 5*60;
     }
 
-
-
+    level_load.next("entities");
     std::clog << "Creating player..." << std::endl;
     player = entities.create_entity();
-    entities.create_component(player, component::position{float(int(test_stage_json["spawn"]["c"])*16+8),float(int(test_stage_json["spawn"]["r"])*16+8)});
+    entities.create_component(player, component::position{float(stage_info.spawn.c*16+8),float(stage_info.spawn.r*16+8)});
     entities.create_component(player, component::velocity{0, 0});
     entities.create_component(player, component::aabb{-8,8,-8,8});
     entities.create_component(player, component::drunken{});
     // Default fist direction
     entities.create_component(player, component::fistdir::RIGHT);
     entities.create_component(player, component::health{3});
-    entities.create_component(player, component::animated_sprite{"tipsy", "idle", 0, 0});
+    entities.create_component(player, component::animated_sprite{resources::animated_sprites.intern(gameplay_resources::PLAYER), idle_anim, tick});
 
     // player handles most collisions
     auto player_collider = [&](database::ent_id self, database::ent_id other) {
@@ -82,9 +99,7 @@ bool gameplay_state::init() {
             entities.create_component(self, component::timed_force{dirx*8, diry*8, 5});
             entities.create_component(other, component::timed_force{-dirx*8, -diry*8, 5});
 
-            auto a = resources::wavs.get("elfattack");
-            g_soloud->stopAudioSource(*a);
-            g_soloud->play(*a, 0.7);
+            sfx::play(gameplay_resources::ELF_ATTACK_SOUND, 0.7);
         } else if (entities.has_component<component::booze>(other)) {
             auto& booze = entities.get_component<component::booze>(other);
             auto& drunk = entities.get_component<component::drunken>(self);
@@ -92,9 +107,7 @@ bool gameplay_state::init() {
             drunk.bac += booze.value;
             deadentities.push_back(other);
 
-            auto a = resources::wavs.get("gulp");
-            g_soloud->stopAudioSource(*a);
-            g_soloud->play(*a);
+            sfx::play(gameplay_resources::GULP_SOUND);
         }
     };
     entities.create_component(player, component::collider{player_collider});
@@ -114,11 +127,11 @@ bool gameplay_state::init() {
         self_pos.y += diry;
     };
 
-    for(auto& elf : test_stage_json["elves"])
+    for(auto& elf : stage_info.elves)
     {
         auto enemy = entities.create_entity();
-        entities.create_component(enemy, component::position{float(elf[1])*16+8, float(elf[0])*16+8});
-        entities.create_component(enemy, component::animated_sprite{"elf", "idle", 0, 0});
+        entities.create_component(enemy, component::position{float(elf.c)*16+8, float(elf.r)*16+8});
+        entities.create_component(enemy, component::animated_sprite{resources::animated_sprites.intern(gameplay_resources::ELF), idle_anim, tick});
         entities.create_component(enemy, component::brain{enemythink});
         entities.create_component(enemy, component::aabb{-8, 8, -8, 8});
         entities.create_component(enemy, component::elf_tag{});
@@ -148,18 +161,20 @@ bool gameplay_state::init() {
         entities.create_component(enemy, component::collider{elf_collider});
     }
 
-    for (auto& beerjson : test_stage_json["beers"])
+    for (auto& beer : stage_info.beers)
     {
         auto ent = entities.create_entity();
-        entities.create_component(ent, component::position{float(beerjson[1])*16+8, float(beerjson[0])*16+8});
-        entities.create_component(ent, component::animated_sprite{"beer", "idle", 0, 0});
+        entities.create_component(ent, component::position{float(beer.c)*16+8, float(beer.r)*16+8});
+        entities.create_component(ent, component::animated_sprite{resources::animated_sprites.intern(gameplay_resources::BEER), idle_anim, tick});
         entities.create_component(ent, component::aabb{-8, 8, -8, 8});
         entities.create_component(ent, component::booze{1});
         entities.create_component(ent, component::beer_tag{});
     }
 
+    level_load.next("render setup");
     framebuffer = sushi::create_framebuffer(utility::vectorify(sushi::create_uninitialized_texture_2d(320, 240)));
     framebuffer_mesh = sprite_mesh(framebuffer.color_texs[0]);
+    sprites = sprite_batch(256);
 
     std::clog << "Loading basic shader..." << std::endl;
     program = sushi::link_program({
@@ -174,6 +189,9 @@ bool gameplay_state::init() {
     glBindAttribLocation(program.get(), sushi::attrib_location::TEXCOORD, "texcoord");
     glBindAttribLocation(program.get(), sushi::attrib_location::NORMAL, "normal");
 
+    // Load the next stage while this one is played.
+    campaign::prefetch(stage + 1);
+
     initted = true;
     return true;
 }
@@ -189,11 +207,13 @@ void gameplay_state::operator()() {
         std::clog << "Loser" << std::endl;
         mainloop::states.pop_back();
         mainloop::states.push_back(end_state("lose"));
-        g_soloud->stopAll();
-        g_soloud->play(*resources::wavs.get("death"));
+        sfx::stop_all();
+        sfx::play(gameplay_resources::DEATH_SOUND);
         return;
     }
 
+    ++tick;
+
     SDL_Event event;
     while (SDL_PollEvent(&event))
     {
@@ -240,9 +260,7 @@ void gameplay_state::operator()() {
                              }
                              force.duration = 10;
                              entities.create_component(other, force);
-                             auto a = resources::wavs.get("punch");
-                             g_soloud->stopAudioSource(*a);
-                             g_soloud->play(*a);
+                             sfx::play(gameplay_resources::PUNCH_SOUND);
                          }
                      };
 
@@ -259,22 +277,22 @@ void gameplay_state::operator()() {
                      switch (dir) {
                         case component::fistdir::RIGHT:
                             entities.create_component(fist, component::position{player_pos.x+16, player_pos.y});
-                            entities.create_component(fist, component::animated_sprite{"rightfist", "idle", 0, 0});
+                            entities.create_component(fist, component::animated_sprite{resources::animated_sprites.intern(gameplay_resources::RIGHT_FIST), idle_anim, tick});
                             break;
 
                         case component::fistdir::LEFT:
                             entities.create_component(fist, component::position{player_pos.x-16, player_pos.y});
-                            entities.create_component(fist, component::animated_sprite{"leftfist", "idle", 0, 0});
+                            entities.create_component(fist, component::animated_sprite{resources::animated_sprites.intern(gameplay_resources::LEFT_FIST), idle_anim, tick});
                             break;
 
                         case component::fistdir::UP:
                             entities.create_component(fist, component::position{player_pos.x, player_pos.y+16});
-                            entities.create_component(fist, component::animated_sprite{"upfist", "idle", 0, 0});
+                            entities.create_component(fist, component::animated_sprite{resources::animated_sprites.intern(gameplay_resources::UP_FIST), idle_anim, tick});
                             break;
 
                         case component::fistdir::DOWN:
                             entities.create_component(fist, component::position{player_pos.x, player_pos.y-16});
-                            entities.create_component(fist, component::animated_sprite{"downfist", "idle", 0, 0});
+                            entities.create_component(fist, component::animated_sprite{resources::animated_sprites.intern(gameplay_resources::DOWN_FIST), idle_anim, tick});
                             break;
                      }
                 } break;
@@ -306,8 +324,8 @@ void gameplay_state::operator()() {
         player_vel.x -= 1;
         entities.create_component(player, component::fistdir::LEFT);
         auto& anim = entities.get_component<component::animated_sprite>(player);
-        if (anim.anim != "left") {
-            anim = {"tipsy", "left", 0, 0};
+        if (anim.anim != left_anim) {
+            anim = {anim.sprite, left_anim, tick};
         }
     }
 
@@ -315,8 +333,8 @@ void gameplay_state::operator()() {
         player_vel.x += 1;
         entities.create_component(player, component::fistdir::RIGHT);
         auto& anim = entities.get_component<component::animated_sprite>(player);
-        if (anim.anim != "idle") {
-            anim = {"tipsy", "idle", 0, 0};
+        if (anim.anim != idle_anim) {
+            anim = {anim.sprite, idle_anim, tick};
         }
     }
 
@@ -334,9 +352,9 @@ void gameplay_state::operator()() {
     {
         glClearColor(0,0,0,1);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        sushi::set_depth_test(true);
+        sushi::set_blend(true);
+        sushi::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glViewport(0, 0, 320, 240);
 
         auto projmat = glm::ortho(0.f, 320.f, 0.f, 240.f, -10.f, 10.f);
@@ -360,38 +378,20 @@ void gameplay_state::operator()() {
         else
             cammat = glm::rotate(cammat, -tiltfactor, glm::vec3{0,0,1});
 
-        auto tilesheet = resources::spritesheets.get("tiles", 16, 16);
-
         auto first_row = std::max(int((player_pos.y - 8)/16)-7, 0);
         auto last_row = std::min(int((player_pos.y - 8)/16)+9, test_stage.get_num_rows());
         auto first_col = std::max(int((player_pos.x - 8)/16)-10, 0);
         auto last_col = std::min(int((player_pos.x - 8)/16)+13, test_stage.get_num_cols());
 
-        for (auto r = first_row; r < last_row; ++r) {
-            for (auto c = first_col; c < last_col; ++c) {
-                auto& tile = test_stage.get(r, c);
-                if (tile.flags & tilemap::BACKGROUND || tile.flags & tilemap::FOREGROUND) {
-                    auto modelmat = glm::mat4(1.f);
-                    modelmat = glm::translate(modelmat, glm::vec3{8, 8, 0});
-                    modelmat = glm::translate(modelmat, glm::vec3{c*16, r*16, 0});
-                    sushi::set_program(program);
-                    sushi::set_uniform("cam_forward", glm::vec3{0,0,-1});
-                    sushi::set_uniform("s_texture", 0);
-                    sushi::set_texture(0, tilesheet->get_texture());
-                    if (tile.flags & tilemap::BACKGROUND) {
-                        sushi::set_uniform("MVP", projmat * cammat * modelmat);
-                        sushi::set_uniform("normal_mat", glm::transpose(glm::inverse(modelmat)));
-                        sushi::draw_mesh(tilesheet->get_mesh(tile.background/16, tile.background%16));
-                    }
-                    if (tile.flags & tilemap::FOREGROUND) {
-                        auto raised_modelmat = glm::translate(modelmat, glm::vec3{0, 0, 1});
-                        sushi::set_uniform("MVP", projmat * cammat * raised_modelmat);
-                        sushi::set_uniform("normal_mat", glm::transpose(glm::inverse(cammat * raised_modelmat)));
-                        sushi::draw_mesh(tilesheet->get_mesh(tile.foreground/16, tile.foreground%16));
-                    }
-                }
-            }
-        }
+        test_stage_mesh.update(test_stage);
+
+        sushi::set_program(program);
+        sushi::set_uniform("cam_forward", glm::vec3{0,0,-1});
+        sushi::set_uniform("s_texture", 0);
+        sushi::set_uniform("MVP", projmat * cammat);
+        sushi::set_uniform("normal_mat", glm::mat4(1.f));
+        test_stage_mesh.draw(tilemap::tilemap_mesh::BACKGROUND_LAYER, first_row, last_row, first_col, last_col);
+        test_stage_mesh.draw(tilemap::tilemap_mesh::FOREGROUND_LAYER, first_row, last_row, first_col, last_col);
 
         entities.visit([&](component::brain& brain, database::ent_id self) {
             brain.think(self);
@@ -460,6 +460,9 @@ void gameplay_state::operator()() {
             });
         });
 
+        // Read-only access, so the collision checks don't mark chunks as changed.
+        const auto& stage = test_stage;
+
         entities.visit([&](component::position& pos, component::aabb aabb){
             constexpr auto epsilon = 0.0001;
             aabb.left += epsilon;
@@ -472,8 +475,8 @@ void gameplay_state::operator()() {
                 auto rp = pos.y + aabb.bottom - r * 16;
                 auto cp = pos.x + aabb.left - c * 16;
 
-                if (r >= 0 && c >= 0 && r < test_stage.get_num_rows() && c < test_stage.get_num_cols()) {
-                    if (test_stage.get(r, c).flags & tilemap::WALL) {
+                if (r >= 0 && c >= 0 && r < stage.get_num_rows() && c < stage.get_num_cols()) {
+                    if (stage.get(r, c).flags & tilemap::WALL) {
                         if (rp > cp) {
                             pos.y += 16 - rp;
                         } else {
@@ -488,8 +491,8 @@ void gameplay_state::operator()() {
                 auto rp = pos.y + aabb.bottom - r * 16;
                 auto cp = pos.x + aabb.right - c * 16;
 
-                if (r >= 0 && c >= 0 && r < test_stage.get_num_rows() && c < test_stage.get_num_cols()) {
-                    if (test_stage.get(r, c).flags & tilemap::WALL) {
+                if (r >= 0 && c >= 0 && r < stage.get_num_rows() && c < stage.get_num_cols()) {
+                    if (stage.get(r, c).flags & tilemap::WALL) {
                         if (rp > (16-cp)) {
                             pos.y += 16 - rp;
                         } else {
@@ -504,8 +507,8 @@ void gameplay_state::operator()() {
                 auto rp = pos.y + aabb.top - r * 16;
                 auto cp = pos.x + aabb.left - c * 16;
 
-                if (r >= 0 && c >= 0 && r < test_stage.get_num_rows() && c < test_stage.get_num_cols()) {
-                    if (test_stage.get(r, c).flags & tilemap::WALL) {
+                if (r >= 0 && c >= 0 && r < stage.get_num_rows() && c < stage.get_num_cols()) {
+                    if (stage.get(r, c).flags & tilemap::WALL) {
                         if ((16-rp) > cp) {
                             pos.y -= rp;
                         } else {
@@ -520,8 +523,8 @@ void gameplay_state::operator()() {
                 auto rp = pos.y + aabb.top - r * 16;
                 auto cp = pos.x + aabb.right - c * 16;
 
-                if (r >= 0 && c >= 0 && r < test_stage.get_num_rows() && c < test_stage.get_num_cols()) {
-                    if (test_stage.get(r, c).flags & tilemap::WALL) {
+                if (r >= 0 && c >= 0 && r < stage.get_num_rows() && c < stage.get_num_cols()) {
+                    if (stage.get(r, c).flags & tilemap::WALL) {
                         if (rp < cp) {
                             pos.y -= rp;
                         } else {
@@ -532,52 +535,30 @@ void gameplay_state::operator()() {
             }
         });
 
-        entities.visit([&](const component::position& pos, component::animated_sprite& sprite) {
+        // Each kind of sprite is looked up in the cache once per frame, not once per entity.
+        decltype(resources::animated_sprites)::resolver animations (resources::animated_sprites);
+
+        entities.visit([&](const component::position& pos, const component::animated_sprite& sprite) {
             if (std::abs(pos.x-player_pos.x) > 168 || std::abs(pos.y-player_pos.y) > 128) return;
+            if (!sprite.sprite) return; // Scripts can create sprites without a name
 
-            auto animation = resources::animated_sprites.get(sprite.name);
+            auto& animation = animations.get(sprite.sprite);
             auto& sheet = animation->get_spritesheet();
             auto& anim = animation->get_anim(sprite.anim);
 
-            --sprite.frame_time;
-
-            if (sprite.frame_time < 0) {
-                if (sprite.cur_frame == anim.frames.size()-1) {
-                    if (anim.loops) {
-                        sprite.cur_frame = 0;
-                        sprite.frame_time = anim.frames[0].duration;
-                    } else {
-                        sprite.frame_time = 0;
-                    }
-                } else {
-                    ++sprite.cur_frame;
-                    sprite.frame_time = anim.frames[sprite.cur_frame].duration;
-                }
-            }
-
-            auto& texture = sheet.get_texture();
-            auto cell = anim.frames[sprite.cur_frame].cell;
-            auto& mesh = sheet.get_mesh(cell/16, cell%16);
-
-            auto modelmat = glm::mat4(1.f);
-            modelmat = glm::translate(modelmat, glm::vec3{pos.x, pos.y, 0});
-            sushi::set_program(program);
-            sushi::set_uniform("cam_forward", glm::vec3{0,0,-1});
-            sushi::set_uniform("s_texture", 0);
-            sushi::set_uniform("MVP", projmat * cammat * modelmat);
-            sushi::set_uniform("normal_mat", glm::transpose(glm::inverse(modelmat)));
-            sushi::set_texture(0, texture);
-            sushi::draw_mesh(mesh);
+            sprites.add(sheet, anim.get_cell(tick - sprite.start_tick), {pos.x, pos.y});
         });
+
+        sprites.draw(projmat * cammat);
     }
 
     sushi::set_framebuffer(nullptr);
     {
         glClearColor(0,0,0,1);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glDisable(GL_DEPTH_TEST);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        sushi::set_depth_test(false);
+        sushi::set_blend(true);
+        sushi::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glViewport(0, 0, 640, 480);
 
         auto projmat = glm::ortho(-160.f, 160.f, -120.f, 120.f, -1.f, 1.f);
@@ -590,8 +571,12 @@ void gameplay_state::operator()() {
         sushi::set_texture(0, framebuffer.color_texs[0]);
         sushi::draw_mesh(framebuffer_mesh);
 
-        auto font = resources::fonts.get("LiberationSans-Regular");
-        draw_string(*font, std::to_string(rem_time/60), projmat, {160, 120-16}, 16, text_align::RIGHT);
+        // The countdown only changes once a second, so only then is its text laid out again.
+        if (rem_time/60 != hud_seconds) {
+            hud_seconds = rem_time/60;
+            hud_time.set(resources::fonts.get(gameplay_resources::FONT), std::to_string(hud_seconds), 16, text_align::RIGHT);
+        }
+        hud_time.draw(projmat, {160, 120-16});
     }
 
     for(auto e : deadentities)
@@ -2,6 +2,9 @@
 #define LD40_GAMEPLAY_STATE_HPP
 
 #include "tilemap.hpp"
+#include "tilemap_mesh.hpp"
+#include "sprite_batch.hpp"
+#include "text.hpp"
 
 #include "entities.hpp"
 
@@ -16,10 +19,12 @@ public:
     void operator()();
 private:
     tilemap::tilemap test_stage;
+    tilemap::tilemap_mesh test_stage_mesh;
 
     sushi::framebuffer framebuffer;
     sushi::static_mesh framebuffer_mesh;
     sushi::unique_program program;
+    sprite_batch sprites;
 
     database entities;
     std::vector<database::ent_id> deadentities;
@@ -31,6 +36,10 @@ private:
     std::string levelname;
 
     int rem_time;
+    int tick = 0;
+
+    int hud_seconds = -1;
+    text_layout hud_time;
 };
 
 #endif //LD40_GAMEPLAY_STATE_HPP
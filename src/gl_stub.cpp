@@ -0,0 +1,284 @@
+#include "gl_stub.hpp"
+
+#ifndef __EMSCRIPTEN__
+
+#include <array>
+#include <utility>
+
+namespace {
+
+struct recorder {
+    std::vector<std::pair<const char*, int>> counts; // Keyed by the literal's address, so counting never allocates
+    std::vector<gl_stub::draw_call> draws;
+    GLuint next_name = 1;
+    GLenum active_texture = 0;
+    std::array<GLuint, 32> textures = {};
+};
+
+recorder& get_recorder() {
+    static recorder r;
+    return r;
+}
+
+void count(const char* function) {
+    auto& counts = get_recorder().counts;
+    for (auto& c : counts) {
+        if (c.first == function) {
+            ++c.second;
+            return;
+        }
+    }
+    counts.emplace_back(function, 1);
+}
+
+void gen_names(const char* function, GLsizei n, GLuint* names) {
+    count(function);
+    for (auto i = 0; i < n; ++i) {
+        names[i] = get_recorder().next_name++;
+    }
+}
+
+void record_draw(const char* function, GLsizei vertices, GLsizei instances) {
+    count(function);
+    auto& r = get_recorder();
+    r.draws.push_back({function, r.textures[0], vertices, instances});
+}
+
+// Objects
+
+void APIENTRY gen_buffers(GLsizei n, GLuint* names) { gen_names("glGenBuffers", n, names); }
+void APIENTRY gen_textures(GLsizei n, GLuint* names) { gen_names("glGenTextures", n, names); }
+void APIENTRY gen_vertex_arrays(GLsizei n, GLuint* names) { gen_names("glGenVertexArrays", n, names); }
+void APIENTRY gen_framebuffers(GLsizei n, GLuint* names) { gen_names("glGenFramebuffers", n, names); }
+void APIENTRY delete_buffers(GLsizei, const GLuint*) { count("glDeleteBuffers"); }
+void APIENTRY delete_textures(GLsizei, const GLuint*) { count("glDeleteTextures"); }
+void APIENTRY delete_vertex_arrays(GLsizei, const GLuint*) { count("glDeleteVertexArrays"); }
+void APIENTRY delete_framebuffers(GLsizei, const GLuint*) { count("glDeleteFramebuffers"); }
+
+// Shaders
+
+GLuint APIENTRY create_shader(GLenum) {
+    count("glCreateShader");
+    return get_recorder().next_name++;
+}
+
+GLuint APIENTRY create_program() {
+    count("glCreateProgram");
+    return get_recorder().next_name++;
+}
+
+void APIENTRY shader_source(GLuint, GLsizei, const GLchar* const*, const GLint*) { count("glShaderSource"); }
+void APIENTRY compile_shader(GLuint) { count("glCompileShader"); }
+void APIENTRY attach_shader(GLuint, GLuint) { count("glAttachShader"); }
+void APIENTRY bind_attrib_location(GLuint, GLuint, const GLchar*) { count("glBindAttribLocation"); }
+void APIENTRY link_program(GLuint) { count("glLinkProgram"); }
+void APIENTRY use_program(GLuint) { count("glUseProgram"); }
+void APIENTRY delete_shader(GLuint) { count("glDeleteShader"); }
+void APIENTRY delete_program(GLuint) { count("glDeleteProgram"); }
+
+void APIENTRY get_shader_iv(GLuint, GLenum pname, GLint* params) {
+    count("glGetShaderiv");
+    *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+void APIENTRY get_program_iv(GLuint, GLenum pname, GLint* params) {
+    count("glGetProgramiv");
+    *params = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+void APIENTRY get_shader_info_log(GLuint, GLsizei size, GLsizei* length, GLchar* log) {
+    count("glGetShaderInfoLog");
+    if (length) *length = 0;
+    if (size > 0) log[0] = '\0';
+}
+
+void APIENTRY get_program_info_log(GLuint, GLsizei size, GLsizei* length, GLchar* log) {
+    count("glGetProgramInfoLog");
+    if (length) *length = 0;
+    if (size > 0) log[0] = '\0';
+}
+
+GLint APIENTRY get_uniform_location(GLuint, const GLchar*) {
+    count("glGetUniformLocation");
+    return 0;
+}
+
+void APIENTRY uniform_1i(GLint, GLint) { count("glUniform1i"); }
+void APIENTRY uniform_1f(GLint, GLfloat) { count("glUniform1f"); }
+void APIENTRY uniform_2fv(GLint, GLsizei, const GLfloat*) { count("glUniform2fv"); }
+void APIENTRY uniform_3fv(GLint, GLsizei, const GLfloat*) { count("glUniform3fv"); }
+void APIENTRY uniform_4fv(GLint, GLsizei, const GLfloat*) { count("glUniform4fv"); }
+void APIENTRY uniform_matrix_4fv(GLint, GLsizei, GLboolean, const GLfloat*) { count("glUniformMatrix4fv"); }
+
+// Buffers and vertex arrays
+
+void APIENTRY bind_buffer(GLenum, GLuint) { count("glBindBuffer"); }
+void APIENTRY buffer_data(GLenum, GLsizeiptr, const void*, GLenum) { count("glBufferData"); }
+void APIENTRY bind_vertex_array(GLuint) { count("glBindVertexArray"); }
+void APIENTRY enable_vertex_attrib_array(GLuint) { count("glEnableVertexAttribArray"); }
+void APIENTRY vertex_attrib_pointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) { count("glVertexAttribPointer"); }
+void APIENTRY vertex_attrib_divisor(GLuint, GLuint) { count("glVertexAttribDivisor"); }
+
+// Textures
+
+void APIENTRY active_texture(GLenum unit) {
+    count("glActiveTexture");
+    get_recorder().active_texture = unit - GL_TEXTURE0;
+}
+
+void APIENTRY bind_texture(GLenum, GLuint texture) {
+    count("glBindTexture");
+    auto& r = get_recorder();
+    if (r.active_texture < r.textures.size()) {
+        r.textures[r.active_texture] = texture;
+    }
+}
+
+void APIENTRY tex_image_2d(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const void*) { count("glTexImage2D"); }
+void APIENTRY tex_sub_image_2d(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, const void*) { count("glTexSubImage2D"); }
+void APIENTRY tex_parameter_i(GLenum, GLenum, GLint) { count("glTexParameteri"); }
+void APIENTRY tex_parameter_f(GLenum, GLenum, GLfloat) { count("glTexParameterf"); }
+void APIENTRY generate_mipmap(GLenum) { count("glGenerateMipmap"); }
+
+// Framebuffers
+
+void APIENTRY bind_framebuffer(GLenum, GLuint) { count("glBindFramebuffer"); }
+void APIENTRY framebuffer_texture_2d(GLenum, GLenum, GLenum, GLuint, GLint) { count("glFramebufferTexture2D"); }
+void APIENTRY framebuffer_texture_ext(GLenum, GLenum, GLuint, GLint) { count("glFramebufferTextureEXT"); }
+void APIENTRY draw_buffers(GLsizei, const GLenum*) { count("glDrawBuffers"); }
+
+GLenum APIENTRY check_framebuffer_status(GLenum) {
+    count("glCheckFramebufferStatus");
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+// State and drawing
+
+void APIENTRY enable(GLenum) { count("glEnable"); }
+void APIENTRY disable(GLenum) { count("glDisable"); }
+void APIENTRY blend_func(GLenum, GLenum) { count("glBlendFunc"); }
+void APIENTRY viewport(GLint, GLint, GLsizei, GLsizei) { count("glViewport"); }
+void APIENTRY clear_color(GLfloat, GLfloat, GLfloat, GLfloat) { count("glClearColor"); }
+void APIENTRY clear(GLbitfield) { count("glClear"); }
+
+GLboolean APIENTRY is_enabled(GLenum) {
+    count("glIsEnabled");
+    return GL_FALSE;
+}
+
+void APIENTRY get_integer_v(GLenum, GLint* data) {
+    count("glGetIntegerv");
+    *data = 0;
+}
+
+void APIENTRY get_float_v(GLenum, GLfloat* data) {
+    count("glGetFloatv");
+    *data = 1;
+}
+
+const GLubyte* APIENTRY get_string(GLenum) {
+    count("glGetString");
+    return reinterpret_cast<const GLubyte*>("gl_stub");
+}
+
+void APIENTRY draw_arrays(GLenum, GLint, GLsizei n) { record_draw("glDrawArrays", n, 1); }
+void APIENTRY draw_arrays_instanced(GLenum, GLint, GLsizei n, GLsizei instances) { record_draw("glDrawArraysInstanced", n, instances); }
+void APIENTRY draw_elements(GLenum, GLsizei n, GLenum, const void*) { record_draw("glDrawElements", n, 1); }
+
+} //static
+
+namespace gl_stub {
+
+void load() {
+    glGenBuffers = gen_buffers;
+    glGenTextures = gen_textures;
+    glGenVertexArrays = gen_vertex_arrays;
+    glGenFramebuffers = gen_framebuffers;
+    glDeleteBuffers = delete_buffers;
+    glDeleteTextures = delete_textures;
+    glDeleteVertexArrays = delete_vertex_arrays;
+    glDeleteFramebuffers = delete_framebuffers;
+
+    glCreateShader = create_shader;
+    glCreateProgram = create_program;
+    glShaderSource = shader_source;
+    glCompileShader = compile_shader;
+    glAttachShader = attach_shader;
+    glBindAttribLocation = bind_attrib_location;
+    glLinkProgram = link_program;
+    glUseProgram = use_program;
+    glDeleteShader = delete_shader;
+    glDeleteProgram = delete_program;
+    glGetShaderiv = get_shader_iv;
+    glGetProgramiv = get_program_iv;
+    glGetShaderInfoLog = get_shader_info_log;
+    glGetProgramInfoLog = get_program_info_log;
+    glGetUniformLocation = get_uniform_location;
+    glUniform1i = uniform_1i;
+    glUniform1f = uniform_1f;
+    glUniform2fv = uniform_2fv;
+    glUniform3fv = uniform_3fv;
+    glUniform4fv = uniform_4fv;
+    glUniformMatrix4fv = uniform_matrix_4fv;
+
+    glBindBuffer = bind_buffer;
+    glBufferData = buffer_data;
+    glBindVertexArray = bind_vertex_array;
+    glEnableVertexAttribArray = enable_vertex_attrib_array;
+    glVertexAttribPointer = vertex_attrib_pointer;
+    glVertexAttribDivisor = vertex_attrib_divisor;
+
+    glActiveTexture = active_texture;
+    glBindTexture = bind_texture;
+    glTexImage2D = tex_image_2d;
+    glTexSubImage2D = tex_sub_image_2d;
+    glTexParameteri = tex_parameter_i;
+    glTexParameterf = tex_parameter_f;
+    glGenerateMipmap = generate_mipmap;
+
+    glBindFramebuffer = bind_framebuffer;
+    glFramebufferTexture2D = framebuffer_texture_2d;
+    glFramebufferTextureEXT = framebuffer_texture_ext;
+    glDrawBuffers = draw_buffers;
+    glCheckFramebufferStatus = check_framebuffer_status;
+
+    glEnable = enable;
+    glDisable = disable;
+    glBlendFunc = blend_func;
+    glViewport = viewport;
+    glClearColor = clear_color;
+    glClear = clear;
+    glIsEnabled = is_enabled;
+    glGetIntegerv = get_integer_v;
+    glGetFloatv = get_float_v;
+    glGetString = get_string;
+
+    glDrawArrays = draw_arrays;
+    glDrawArraysInstanced = draw_arrays_instanced;
+    glDrawElements = draw_elements;
+
+    reset();
+}
+
+int get_call_count(const std::string& function) {
+    for (auto& c : get_recorder().counts) {
+        if (function == c.first) {
+            return c.second;
+        }
+    }
+    return 0;
+}
+
+const std::vector<draw_call>& get_draw_calls() {
+    return get_recorder().draws;
+}
+
+void reset() {
+    auto& r = get_recorder();
+    r.counts.clear();
+    r.draws.clear();
+}
+
+} //namespace gl_stub
+
+#endif
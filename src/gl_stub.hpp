@@ -0,0 +1,34 @@
+#ifndef LD40_GL_STUB_HPP
+#define LD40_GL_STUB_HPP
+
+#include <sushi/gl.hpp>
+
+#include <string>
+#include <vector>
+
+// Stand-ins for the OpenGL entry points the game uses, so rendering code can run without a window or GPU,
+// such as in benchmarks and headless runs. Desktop only.
+// The stubs do nothing but record what was called: object names are handed out in order and shaders always compile.
+namespace gl_stub {
+
+struct draw_call {
+    const char* function; // e.g. "glDrawArraysInstanced"
+    GLuint texture; // Bound to unit 0 at the time
+    GLsizei count; // Vertices or indices
+    GLsizei instances; // 1 unless instanced
+};
+
+// Points glad's function pointers at the stubs. Replaces any real context's entry points.
+void load();
+
+// Calls to an entry point, by its GL name, since load() or the last reset().
+int get_call_count(const std::string& function);
+
+const std::vector<draw_call>& get_draw_calls();
+
+// Clears the recorded calls. Object names and bindings are kept.
+void reset();
+
+} //namespace gl_stub
+
+#endif //LD40_GL_STUB_HPP
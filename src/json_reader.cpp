@@ -0,0 +1,213 @@
+#include "json_reader.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void append_utf8(std::string& out, unsigned cp) {
+    if (cp < 0x80) {
+        out += char(cp);
+    } else if (cp < 0x800) {
+        out += char(0xC0 | (cp >> 6));
+        out += char(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += char(0xE0 | (cp >> 12));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    } else {
+        out += char(0xF0 | (cp >> 18));
+        out += char(0x80 | ((cp >> 12) & 0x3F));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    }
+}
+
+} //static
+
+json_reader::json_reader(const char* begin, const char* end) : begin(begin), pos(begin), end(end) {}
+
+bool json_reader::read_null() {
+    skip_whitespace();
+    if (pos != end && *pos == 'n') {
+        expect_literal("null");
+        return true;
+    }
+    return false;
+}
+
+bool json_reader::read_bool() {
+    skip_whitespace();
+    if (pos != end && *pos == 't') {
+        expect_literal("true");
+        return true;
+    }
+    expect_literal("false");
+    return false;
+}
+
+int json_reader::read_int() {
+    skip_whitespace();
+    auto start = pos;
+    auto negative = pos != end && *pos == '-';
+    if (negative) {
+        ++pos;
+    }
+    if (pos == end || !is_digit(*pos)) {
+        fail("Expected a number");
+    }
+    long long value = 0;
+    while (pos != end && is_digit(*pos)) {
+        value = value * 10 + (*pos - '0');
+        ++pos;
+    }
+    // Integers are the common case, anything with a fraction or exponent goes through read_number().
+    if (pos != end && (*pos == '.' || *pos == 'e' || *pos == 'E')) {
+        pos = start;
+        return int(read_number());
+    }
+    return int(negative ? -value : value);
+}
+
+double json_reader::read_number() {
+    skip_whitespace();
+    auto start = pos;
+    while (pos != end && (is_digit(*pos) || std::strchr("+-.eE", *pos))) {
+        ++pos;
+    }
+    // The buffer isn't null-terminated, so strtod needs a copy.
+    std::string token (start, pos);
+    char* token_end = nullptr;
+    auto value = std::strtod(token.c_str(), &token_end);
+    if (token.empty() || token_end != token.c_str() + token.size()) {
+        pos = start;
+        fail("Expected a number");
+    }
+    return value;
+}
+
+std::string json_reader::read_string() {
+    std::string str;
+    read_string(str);
+    return str;
+}
+
+void json_reader::read_string(std::string& out) {
+    expect('"');
+    out.clear();
+    while (true) {
+        auto run = pos;
+        while (pos != end && *pos != '"' && *pos != '\\') {
+            ++pos;
+        }
+        out.append(run, pos);
+        if (pos == end) {
+            fail("Unterminated string");
+        }
+        if (*pos++ == '"') {
+            return;
+        }
+        if (pos == end) {
+            fail("Unterminated string");
+        }
+        switch (*pos++) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                auto read_hex = [&]{
+                    unsigned cp = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        auto digit = pos == end ? -1 : hex_value(*pos++);
+                        if (digit < 0) {
+                            fail("Bad \\u escape");
+                        }
+                        cp = cp * 16 + digit;
+                    }
+                    return cp;
+                };
+                auto cp = read_hex();
+                if (cp >= 0xD800 && cp < 0xDC00 && end - pos >= 2 && pos[0] == '\\' && pos[1] == 'u') {
+                    pos += 2;
+                    auto low = read_hex();
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default:
+                fail("Bad escape");
+        }
+    }
+}
+
+void json_reader::skip() {
+    skip_whitespace();
+    if (pos == end) {
+        fail("Expected a value");
+    }
+    switch (*pos) {
+        case '{': read_object([&](const std::string&){ skip(); }); break;
+        case '[': read_array([&]{ skip(); }); break;
+        case '"': read_string(key); break;
+        case 't': case 'f': read_bool(); break;
+        case 'n': read_null(); break;
+        default: read_number(); break;
+    }
+}
+
+void json_reader::finish() {
+    skip_whitespace();
+    if (pos != end) {
+        fail("Unexpected data after the document");
+    }
+}
+
+void json_reader::skip_whitespace() {
+    while (pos != end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t')) {
+        ++pos;
+    }
+}
+
+bool json_reader::consume(char c) {
+    skip_whitespace();
+    if (pos != end && *pos == c) {
+        ++pos;
+        return true;
+    }
+    return false;
+}
+
+void json_reader::expect(char c) {
+    if (!consume(c)) {
+        fail(std::string("Expected '") + c + "'");
+    }
+}
+
+void json_reader::expect_literal(const char* literal) {
+    auto length = std::strlen(literal);
+    if (std::size_t(end - pos) < length || std::strncmp(pos, literal, length) != 0) {
+        fail(std::string("Expected ") + literal);
+    }
+    pos += length;
+}
+
+void json_reader::fail(const std::string& what) const {
+    throw json_reader_error("json_reader: " + what + " at offset " + std::to_string(pos - begin) + ".");
+}
@@ -0,0 +1,78 @@
+#ifndef LD40_JSON_READER_HPP
+#define LD40_JSON_READER_HPP
+
+#include <stdexcept>
+#include <string>
+
+class json_reader_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Reads JSON straight out of a buffer, one value at a time, without building a nlohmann::json tree.
+// Loaders walk the document in the order it's written and keep only what they need.
+// Throws json_reader_error on malformed input.
+class json_reader {
+public:
+    json_reader(const char* begin, const char* end);
+
+    // Calls on_member(key) for each member, which must read or skip() the value.
+    // The key is only valid until the value is read.
+    template <typename F>
+    void read_object(F&& on_member) {
+        expect('{');
+        if (consume('}')) {
+            return;
+        }
+        do {
+            read_string(key);
+            expect(':');
+            on_member(static_cast<const std::string&>(key));
+        } while (consume(','));
+        expect('}');
+    }
+
+    // Calls on_element() for each element, which must read or skip() it.
+    template <typename F>
+    void read_array(F&& on_element) {
+        expect('[');
+        if (consume(']')) {
+            return;
+        }
+        do {
+            on_element();
+        } while (consume(','));
+        expect(']');
+    }
+
+    // Consumes a null and returns true, or returns false and leaves any other value to be read.
+    bool read_null();
+
+    bool read_bool();
+
+    int read_int();
+
+    double read_number();
+
+    std::string read_string();
+
+    void skip();
+
+    // Checks that only whitespace is left.
+    void finish();
+
+private:
+    void read_string(std::string& out);
+    void skip_whitespace();
+    bool consume(char c);
+    void expect(char c);
+    void expect_literal(const char* literal);
+    [[noreturn]] void fail(const std::string& what) const;
+
+    const char* begin;
+    const char* pos;
+    const char* end;
+    std::string key; // Reused for object keys, so walking members doesn't allocate
+};
+
+#endif //LD40_JSON_READER_HPP
@@ -13,6 +13,9 @@
 #include "animated_sprite.hpp"
 #include "window.hpp"
 #include "soloud.hpp"
+#include "timeline.hpp"
+#include "sfx.hpp"
+#include "gl_stub.hpp"
 
 #include "mainloop.hpp"
 #include "mainmenu_state.hpp"
@@ -41,22 +44,53 @@
 int main(int argc, char* argv[]) try {
     std::clog << "Init..." << std::endl;
 
+    // --startup-benchmark goes straight into the first level and quits after its first frame.
+    // --headless runs without a display, audio device or GPU: SDL's dummy video driver, SoLoud's null driver and a stub GL.
+    // Together they time a cold start from the command line. Desktop only.
+    // --trace=<file> saves the timeline as a Chrome trace on exit.
+    auto startup_benchmark = false;
+    auto headless = false;
+    std::string trace_file;
+    for (auto i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--startup-benchmark") {
+            startup_benchmark = true;
+        } else if (arg == "--headless") {
+#ifdef __EMSCRIPTEN__
+            std::clog << "main: Warning: --headless is not supported on the web." << std::endl;
+#else
+            headless = true;
+#endif
+        } else if (arg.compare(0, 8, "--trace=") == 0) {
+            trace_file = arg.substr(8);
+        }
+    }
+
+    timeline::phases startup ("startup");
+
+    startup.next("Lua test");
     std::clog << "Performing Lua test..." << std::endl;
     sol::state lua;
     lua.set_function("test", []{ std::clog << "Lua Test" << std::endl; });
     lua.script("test()");
 
+    startup.next("SDL init");
     std::clog << "Initializing SDL..." << std::endl;
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) {
+    if (headless) {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    }
+    if (SDL_Init(headless ? SDL_INIT_VIDEO : SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) {
         throw std::runtime_error(SDL_GetError());
     }
 
+    startup.next("SoLoud init");
     std::clog << "Initializing SoLoud..." << std::endl;
     SoLoud::Soloud soloud;
-    soloud.init();
+    soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, headless ? SoLoud::Soloud::NULLDRIVER : SoLoud::Soloud::AUTO);
 
     g_soloud = &soloud;
 
+    startup.next("config");
     std::clog << "Loading config..." << std::endl;
     auto config = emberjs::get_config();
 
@@ -64,13 +98,16 @@ int main(int argc, char* argv[]) try {
     const auto display_height = int(config["display"]["height"]);
     const auto aspect_ratio = float(display_width) / float(display_height);
 
+    startup.next("window");
     std::clog << "Creating window..." << std::endl;
-    g_window = SDL_CreateWindow("LD40", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, display_width, display_height, SDL_WINDOW_OPENGL|SDL_WINDOW_RESIZABLE);
+    Uint32 window_flags = headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_OPENGL|SDL_WINDOW_RESIZABLE;
+    g_window = SDL_CreateWindow("LD40", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, display_width, display_height, window_flags);
 
     if (!g_window) {
         throw std::runtime_error("Failed to create window.");
     }
 
+    startup.next("GL context");
     std::clog << "Creating OpenGL context..." << std::endl;
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
@@ -82,14 +119,27 @@ int main(int argc, char* argv[]) try {
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
 #endif
-    auto glcontext = SDL_GL_CreateContext(g_window);
+    SDL_GLContext glcontext = nullptr;
 
-    if (!glcontext) {
-        throw std::runtime_error("Failed to create OpenGL context.");
+    if (!headless) {
+        glcontext = SDL_GL_CreateContext(g_window);
+
+        if (!glcontext) {
+            throw std::runtime_error("Failed to create OpenGL context.");
+        }
     }
 
+    startup.next("GL extensions");
     std::clog << "Loading OpenGL extenstions..." << std::endl;
+#ifndef __EMSCRIPTEN__
+    if (headless) {
+        gl_stub::load();
+    } else {
+        platform::load_gl_extensions();
+    }
+#else
     platform::load_gl_extensions();
+#endif
 
     std::clog << "OpenGL info:" << std::endl;
     std::clog << "    Vendor: " << (char*)glGetString(GL_VENDOR) << std::endl;
@@ -97,6 +147,12 @@ int main(int argc, char* argv[]) try {
     std::clog << "    GL Version: " << (char*)glGetString(GL_VERSION) << std::endl;
     std::clog << "    GLSL version: " << (char*)glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
 
+#ifdef __EMSCRIPTEN__
+    // The heap is fixed at 32 MB, so drop full-screen images once nothing is showing them.
+    resources::textures.set_budget(4 * 1024 * 1024);
+#endif
+
+    startup.next("fonts");
     std::clog << "Loading fonts..." << std::endl;
     auto font = resources::fonts.get("LiberationSans-Regular");
 
@@ -107,12 +163,28 @@ int main(int argc, char* argv[]) try {
     auto last_update = std::chrono::steady_clock::now();
     auto frame_delay = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::seconds(1)) / 60;
 
+    auto first_frame = true;
+
     mainloop::swap_buffers = [&]{
-        SDL_GL_SwapWindow(g_window);
+        if (!headless) {
+            SDL_GL_SwapWindow(g_window);
+        }
+
+        if (first_frame) {
+            first_frame = false;
+            timeline::mark("first frame");
+            std::clog << "Time to first frame: " << timeline::seconds_since_start() * 1000 << " ms" << std::endl;
+            if (startup_benchmark) {
+                platform::cancel_main_loop();
+            }
+        }
 
     #ifdef __EMSCRIPTEN__
     #else
-        std::this_thread::sleep_until(last_update + frame_delay);
+        // Headless frames aren't shown, so there's nothing to pace.
+        if (!headless) {
+            std::this_thread::sleep_until(last_update + frame_delay);
+        }
         last_update = std::chrono::steady_clock::now();
     #endif
     };
@@ -120,12 +192,29 @@ int main(int argc, char* argv[]) try {
     std::clog << "Init Success." << std::endl;
 
     std::clog << "Starting main loop..." << std::endl;
+    startup.next("main menu");
     mainloop::states.emplace_back(mainmenu_state());
+    if (startup_benchmark) {
+        mainloop::states.emplace_back(gameplay_state(0));
+    }
+    startup.end();
     platform::do_main_loop(mainloop::main_loop, 60, 1);
 
     std::clog << "Cleaning up..." << std::endl;
+    resources::log_stats();
+    sfx::log_stats();
+    timeline::print_summary(std::clog);
+    if (!trace_file.empty()) {
+        if (timeline::write_chrome_trace(trace_file)) {
+            std::clog << "Wrote trace to " << trace_file << "." << std::endl;
+        } else {
+            std::clog << "main: Warning: Unable to write trace to " << trace_file << "." << std::endl;
+        }
+    }
     soloud.deinit();
-    SDL_GL_DeleteContext(glcontext);
+    if (glcontext) {
+        SDL_GL_DeleteContext(glcontext);
+    }
     SDL_DestroyWindow(g_window);
     SDL_Quit();
 
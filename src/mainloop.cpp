@@ -1,18 +1,40 @@
 #include "mainloop.hpp"
 
 #include "platform.hpp"
+#include "async_loader.hpp"
+#include "sfx.hpp"
+
+#ifdef SUSHI_VALIDATE_GL_STATE
+#include <iostream>
+#endif
 
 namespace mainloop {
 
 std::list<_detail::state> states;
 std::function<void()> swap_buffers;
+sushi::state_counters last_frame_gl_state;
 
 void main_loop() {
    if (states.empty()) {
        platform::cancel_main_loop();
    } else {
+       // Finish background loads, such as texture uploads, without stalling the frame.
+       async_loader::update(std::chrono::milliseconds(2));
+
        states.back()();
+       sfx::update();
        swap_buffers();
+
+       last_frame_gl_state = sushi::get_state_counters();
+       sushi::reset_state_counters();
+
+#ifdef SUSHI_VALIDATE_GL_STATE
+       static int frame = 0;
+       if (++frame % 600 == 0) {
+           std::clog << "GL state: " << last_frame_gl_state.calls << " calls, "
+               << last_frame_gl_state.saved << " saved" << std::endl;
+       }
+#endif
    }
 }
 
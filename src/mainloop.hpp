@@ -1,6 +1,8 @@
 #ifndef LD40_MAINLOOP_HPP
 #define LD40_MAINLOOP_HPP
 
+#include <sushi/gl_state.hpp>
+
 #include <list>
 #include <functional>
 #include <memory>
@@ -39,6 +41,9 @@ private:
 extern std::list<_detail::state> states;
 extern std::function<void()> swap_buffers;
 
+// GL state cache counters for the last completed frame.
+extern sushi::state_counters last_frame_gl_state;
+
 void main_loop();
 
 } //namespace mainloop
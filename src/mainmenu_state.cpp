@@ -7,6 +7,7 @@
 #include "sprite.hpp"
 #include "basic_shader.hpp"
 #include "resources.hpp"
+#include "campaign.hpp"
 #include "window.hpp"
 
 #include "gameplay_state.hpp"
@@ -33,6 +34,9 @@ mainmenu_state::mainmenu_state() {
     glBindAttribLocation(program.get(), sushi::attrib_location::POSITION, "position");
     glBindAttribLocation(program.get(), sushi::attrib_location::TEXCOORD, "texcoord");
     glBindAttribLocation(program.get(), sushi::attrib_location::NORMAL, "normal");
+
+    // Load the first stage while the menu is up.
+    campaign::prefetch(0);
 }
 
 void mainmenu_state::operator()() {
@@ -63,9 +67,9 @@ void mainmenu_state::operator()() {
     {
         glClearColor(0,0,0,1);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        sushi::set_depth_test(true);
+        sushi::set_blend(true);
+        sushi::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glViewport(0, 0, 320, 240);
 
         auto mainmenu_tex = resources::textures.get("mainmenu");
@@ -87,8 +91,8 @@ void mainmenu_state::operator()() {
     {
         glClearColor(0,0,0,1);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glDisable(GL_DEPTH_TEST);
-        glDisable(GL_BLEND);
+        sushi::set_depth_test(false);
+        sushi::set_blend(false);
         glViewport(0, 0, 640, 480);
 
         auto projmat = glm::ortho(-160.f, 160.f, 120.f, -120.f, -1.f, 1.f);
@@ -1,45 +1,411 @@
 #ifndef LD40_RESOURCE_CACHE_HPP
 #define LD40_RESOURCE_CACHE_HPP
 
+#include "async_loader.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <type_traits>
-#include <map>
+#include <vector>
+
+// Names a resource by the index of its interned key.
+// Handles are cheap to copy and compare, and stay valid across clear() and reload().
+// A default handle names nothing, and looking it up throws std::out_of_range.
+struct resource_handle {
+    int index = -1;
+
+    explicit operator bool() const {
+        return index >= 0;
+    }
+};
+
+inline bool operator==(resource_handle a, resource_handle b) {
+    return a.index == b.index;
+}
+
+inline bool operator!=(resource_handle a, resource_handle b) {
+    return a.index != b.index;
+}
+
+struct resource_cache_stats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    double load_seconds = 0; // Total time spent loading, including on workers
+    std::size_t resident_bytes = 0; // Only counts caches with a size function
+    std::size_t budget_bytes = 0; // 0 if unlimited
+};
 
+// Selects the resource_cache constructor that takes a two-step loader.
+struct async_factory_t {};
+constexpr async_factory_t async_factory {};
+
+// Safe to use from any thread. Keys are spread over independently locked shards,
+// and each resource is loaded once: concurrent requests for a key that is loading wait for that load.
+// Loads run on the thread that requests them, so resources that touch OpenGL must still be requested from the main thread.
+// With a size function and a byte budget, resources that only the cache still holds are evicted least recently used first.
+// Eviction destroys resources, which may own OpenGL objects, so it only happens on the main thread, in async_loader::update().
 template <typename T, typename... S>
 class resource_cache {
 public:
+    using key_type = std::tuple<S...>;
     using factory_function = std::function<std::shared_ptr<T>(const S&...)>;
+    using finish_function = std::function<std::shared_ptr<T>()>;
+    using prepare_function = std::function<finish_function(const S&...)>;
+    using size_function = std::function<std::size_t(const T&)>;
 
     template <typename F>
     using require_is_not_factory = std::enable_if_t<!std::is_convertible<std::decay_t<F>, factory_function>::value>*;
 
+    // A resource that may still be loading.
+    class future {
+    public:
+        future() = default;
+
+        future(resource_cache* cache, resource_handle h) : cache(cache), h(h) {}
+
+        bool ready() const {
+            return cache->is_loaded(h);
+        }
+
+        // Finishes the load now if it hasn't already.
+        std::shared_ptr<T> get() const {
+            return cache->get(h);
+        }
+
+        resource_handle handle() const {
+            return h;
+        }
+
+    private:
+        resource_cache* cache = nullptr;
+        resource_handle h;
+    };
+
+    // Remembers what each handle resolved to, so looking it up again skips the cache's locks and counters.
+    // Keep one for a frame or so: what it holds can't be evicted, and won't see a reload() until it is dropped.
+    class resolver {
+    public:
+        explicit resolver(resource_cache& cache) : cache(&cache) {}
+
+        const std::shared_ptr<T>& get(resource_handle h) {
+            auto i = std::size_t(h.index);
+            if (h && i < resolved.size() && resolved[i]) {
+                return resolved[i];
+            }
+            auto ptr = cache->get(h);
+            if (i >= resolved.size()) {
+                resolved.resize(i + 1);
+            }
+            resolved[i] = std::move(ptr);
+            return resolved[i];
+        }
+
+    private:
+        resource_cache* cache;
+        std::vector<std::shared_ptr<T>> resolved; // By handle index
+    };
+
     resource_cache(factory_function f) : factory(std::move(f)) {}
 
     template <typename F>
     resource_cache(F&& f, require_is_not_factory<F> = {}) : factory(make_factory(std::forward<F>(f))) {}
 
-    std::shared_ptr<T> get(const S&... s) {
-        auto& ptr = cache[std::tie(s...)];
-        if (!ptr) {
-            ptr = factory(s...);
+    // `prepare` does the CPU work, such as decoding, and may run on a worker thread.
+    // The function it returns finishes the load on the thread that needs the resource, such as by uploading to the GPU.
+    resource_cache(async_factory_t, prepare_function p, size_function s = {}) : prepare(std::move(p)), sizer(std::move(s)) {}
+
+    // Resolves a key to its handle without loading the resource.
+    resource_handle intern(const S&... s) {
+        auto key = std::tie(s...);
+        auto hash = key_hash{}(key);
+        auto shard_index = int(hash % NUM_SHARDS);
+        auto& sh = shards[shard_index];
+
+        std::lock_guard<std::mutex> lock (sh.mutex);
+
+        auto iter = sh.index.find(key);
+        if (iter != end(sh.index)) {
+            return {iter->second * NUM_SHARDS + shard_index};
+        }
+
+        auto local = int(sh.slots.size());
+        sh.slots.push_back({key_type(s...), nullptr, nullptr});
+        sh.index.emplace(sh.slots.back().key, local);
+        return {local * NUM_SHARDS + shard_index};
+    }
+
+    // Loads the resource on first use, or waits for the load already in flight.
+    std::shared_ptr<T> get(resource_handle h) {
+        auto& sh = get_shard(h);
+        std::shared_ptr<pending_load> pending;
+        const key_type* key;
+        auto owner = false;
+
+        {
+            std::lock_guard<std::mutex> lock (sh.mutex);
+            auto& slot = sh.slots[h.index / NUM_SHARDS];
+            if (slot.ptr) {
+                slot.last_use = ++use_clock;
+                ++hits;
+                return slot.ptr;
+            }
+            if (!slot.pending) {
+                slot.pending = std::make_shared<pending_load>();
+                slot.pending->status = pending_load::PREPARING;
+                owner = true;
+                ++misses;
+            }
+            pending = slot.pending;
+            key = &slot.key;
+        }
+
+        if (!owner) {
+            return finish_pending(h, pending, *key);
+        }
+
+        std::shared_ptr<T> ptr;
+        std::exception_ptr error;
+        auto start = std::chrono::steady_clock::now();
+
+        try {
+            ptr = load(*key, std::index_sequence_for<S...>{});
+        } catch (...) {
+            error = std::current_exception();
         }
+
+        add_load_time(start);
+        publish(h, *pending, ptr, error);
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
         return ptr;
     }
 
+    std::shared_ptr<T> get(const S&... s) {
+        return get(intern(s...));
+    }
+
+    // Starts loading the resource in the background, if it isn't loaded or loading already.
+    // Caches without an asynchronous loader still defer the load to async_loader::update().
+    future get_async(const S&... s) {
+        auto h = intern(s...);
+        auto& sh = get_shard(h);
+        std::shared_ptr<pending_load> pending;
+        const key_type* key;
+
+        {
+            std::lock_guard<std::mutex> lock (sh.mutex);
+            auto& slot = sh.slots[h.index / NUM_SHARDS];
+            if (slot.ptr || slot.pending) {
+                return {this, h};
+            }
+            slot.pending = std::make_shared<pending_load>();
+            pending = slot.pending;
+            key = &slot.key;
+            ++misses;
+        }
+
+        if (prepare) {
+            async_loader::run_async([this, h, pending, p=prepare, key=*key]{
+                auto ran = run_prepare(*pending, [&]{ return call_prepare(p, key, std::index_sequence_for<S...>{}); });
+                if (ran) {
+                    async_loader::run_on_main([this, h, pending]{ finish_if_current(h, pending); });
+                }
+            });
+        } else {
+            async_loader::run_on_main([this, h, pending]{ finish_if_current(h, pending); });
+        }
+
+        return {this, h};
+    }
+
+    bool is_loaded(resource_handle h) const {
+        auto& sh = get_shard(h);
+        std::lock_guard<std::mutex> lock (sh.mutex);
+        return bool(sh.slots[h.index / NUM_SHARDS].ptr);
+    }
+
+    // False once a load has finished, failed, or been abandoned by clear().
+    bool is_loading(resource_handle h) const {
+        auto& sh = get_shard(h);
+        std::lock_guard<std::mutex> lock (sh.mutex);
+        return bool(sh.slots[h.index / NUM_SHARDS].pending);
+    }
+
+    const key_type& get_key(resource_handle h) const {
+        auto& sh = get_shard(h);
+        std::lock_guard<std::mutex> lock (sh.mutex);
+        return sh.slots[h.index / NUM_SHARDS].key;
+    }
+
+    // Loads in flight are abandoned. Their waiters still get the result, but it isn't cached.
     void clear() {
-        cache.clear();
+        for (auto& sh : shards) {
+            std::lock_guard<std::mutex> lock (sh.mutex);
+            for (auto& slot : sh.slots) {
+                resident_bytes -= slot.bytes;
+                slot.bytes = 0;
+                slot.ptr = nullptr;
+                slot.pending = nullptr;
+            }
+        }
     }
 
     std::shared_ptr<T> reload(const S&... s) {
-        auto& ptr = cache[std::tie(s...)];
-        ptr = factory(s...);
+        auto h = intern(s...);
+        auto start = std::chrono::steady_clock::now();
+        auto ptr = load(get_key(h), std::index_sequence_for<S...>{});
+        add_load_time(start);
+        auto bytes = measure(ptr);
+        {
+            auto& sh = get_shard(h);
+            std::lock_guard<std::mutex> lock (sh.mutex);
+            auto& slot = sh.slots[h.index / NUM_SHARDS];
+            resident_bytes += bytes - slot.bytes;
+            slot.bytes = bytes;
+            slot.last_use = ++use_clock;
+            slot.pending = nullptr;
+            slot.ptr = ptr;
+        }
+        schedule_trim();
         return ptr;
     }
 
+    // 0 means unlimited. Loads that go over the budget evict until it fits again, if they can.
+    // Only resources measured by the cache's size function count against it. Call it from the main thread.
+    void set_budget(std::size_t bytes) {
+        budget = bytes;
+        trim();
+    }
+
+    // Evicts resources that only the cache holds, least recently used first, until the budget fits.
+    // The evicted resources are destroyed here, so call it from the main thread.
+    void trim() {
+        std::size_t limit = budget;
+
+        if (limit == 0 || resident_bytes <= limit) {
+            return;
+        }
+
+        struct candidate {
+            std::uint64_t last_use;
+            resource_handle h;
+        };
+
+        std::vector<candidate> candidates;
+
+        for (auto s = 0; s < NUM_SHARDS; ++s) {
+            std::lock_guard<std::mutex> lock (shards[s].mutex);
+            auto& slots = shards[s].slots;
+            for (auto i = 0; i < int(slots.size()); ++i) {
+                if (slots[i].ptr && slots[i].bytes > 0 && slots[i].ptr.use_count() == 1) {
+                    candidates.push_back({slots[i].last_use, {i * NUM_SHARDS + s}});
+                }
+            }
+        }
+
+        std::sort(begin(candidates), end(candidates), [](const candidate& a, const candidate& b) {
+            return a.last_use < b.last_use;
+        });
+
+        for (auto& c : candidates) {
+            if (resident_bytes <= limit) {
+                break;
+            }
+
+            std::shared_ptr<T> evicted; // Destroyed outside the lock
+            auto& sh = get_shard(c.h);
+            std::lock_guard<std::mutex> lock (sh.mutex);
+            auto& slot = sh.slots[c.h.index / NUM_SHARDS];
+
+            // Skip anything used or handed out since the scan.
+            if (slot.ptr && slot.last_use == c.last_use && slot.ptr.use_count() == 1) {
+                evicted = std::move(slot.ptr);
+                resident_bytes -= slot.bytes;
+                slot.bytes = 0;
+                ++evictions;
+            }
+        }
+    }
+
+    resource_cache_stats get_stats() const {
+        resource_cache_stats stats;
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.evictions = evictions;
+        stats.load_seconds = load_microseconds / 1e6;
+        stats.resident_bytes = resident_bytes;
+        stats.budget_bytes = budget;
+        return stats;
+    }
+
 private:
+    static constexpr int NUM_SHARDS = 8;
+
+    struct pending_load {
+        enum status_type {
+            QUEUED,
+            PREPARING,
+            PREPARED,
+            FINISHING,
+            DONE
+        };
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        status_type status = QUEUED;
+        std::chrono::steady_clock::duration prepare_time = {};
+        finish_function finish;
+        std::shared_ptr<T> result;
+        std::exception_ptr error;
+    };
+
+    struct slot_type {
+        key_type key;
+        std::shared_ptr<T> ptr;
+        std::shared_ptr<pending_load> pending;
+        std::uint64_t last_use = 0;
+        std::size_t bytes = 0;
+    };
+
+    struct key_hash {
+        template <typename... K>
+        std::size_t operator()(const std::tuple<K...>& key) const {
+            return hash_elements(key, std::index_sequence_for<S...>{});
+        }
+
+        template <typename Tuple, std::size_t... I>
+        static std::size_t hash_elements(const Tuple& key, std::index_sequence<I...>) {
+            std::size_t seed = 0;
+            using expand = int[];
+            (void)expand{0, (seed ^= std::hash<S>{}(std::get<I>(key)) + 0x9e3779b9 + (seed << 6) + (seed >> 2), 0)...};
+            return seed;
+        }
+    };
+
+    struct shard {
+        mutable std::mutex mutex;
+        std::deque<slot_type> slots; // A deque, so interning never moves existing slots
+        std::unordered_map<key_type, int, key_hash> index;
+    };
+
     template <typename F>
     static factory_function make_factory(F&& f) {
         return [f=std::forward<F>(f)](const S&... s) {
@@ -47,9 +413,198 @@ private:
         };
     }
 
+    static int get_shard_index(resource_handle h) {
+        if (!h) {
+            throw std::out_of_range("resource_cache: Invalid resource handle.");
+        }
+        return h.index % NUM_SHARDS;
+    }
+
+    shard& get_shard(resource_handle h) {
+        return shards[get_shard_index(h)];
+    }
+
+    const shard& get_shard(resource_handle h) const {
+        return shards[get_shard_index(h)];
+    }
+
+    template <std::size_t... I>
+    std::shared_ptr<T> load(const key_type& key, std::index_sequence<I...>) {
+        if (prepare) {
+            return prepare(std::get<I>(key)...)();
+        }
+        return factory(std::get<I>(key)...);
+    }
+
+    template <std::size_t... I>
+    static finish_function call_prepare(const prepare_function& p, const key_type& key, std::index_sequence<I...>) {
+        return p(std::get<I>(key)...);
+    }
+
+    // Caches without a prepare step do the whole load when finishing.
+    finish_function make_finish(const key_type& key) {
+        if (prepare) {
+            return call_prepare(prepare, key, std::index_sequence_for<S...>{});
+        }
+        return [this, &key]{ return load(key, std::index_sequence_for<S...>{}); };
+    }
+
+    // Runs the prepare step unless another thread already took it. Returns false if it did.
+    template <typename F>
+    static bool run_prepare(pending_load& pending, F&& prepare_step) {
+        {
+            std::lock_guard<std::mutex> lock (pending.mutex);
+            if (pending.status != pending_load::QUEUED) {
+                return false;
+            }
+            pending.status = pending_load::PREPARING;
+        }
+
+        finish_function finish;
+        std::exception_ptr error;
+        auto start = std::chrono::steady_clock::now();
+
+        try {
+            finish = prepare_step();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock (pending.mutex);
+            pending.prepare_time = std::chrono::steady_clock::now() - start;
+            pending.finish = std::move(finish);
+            pending.error = error;
+            pending.status = error ? pending_load::DONE : pending_load::PREPARED;
+        }
+        pending.cv.notify_all();
+        return true;
+    }
+
+    void finish_if_current(resource_handle h, const std::shared_ptr<pending_load>& pending) {
+        const key_type* key;
+        {
+            auto& sh = get_shard(h);
+            std::lock_guard<std::mutex> lock (sh.mutex);
+            auto& slot = sh.slots[h.index / NUM_SHARDS];
+            if (slot.pending != pending) {
+                return;
+            }
+            key = &slot.key;
+        }
+        finish_pending(h, pending, *key);
+    }
+
+    // Waits for a load in flight, doing whichever of its steps nobody has started yet.
+    std::shared_ptr<T> finish_pending(resource_handle h, const std::shared_ptr<pending_load>& pending, const key_type& key) {
+        run_prepare(*pending, [&]{ return make_finish(key); });
+
+        finish_function finish;
+        std::shared_ptr<T> ptr;
+        std::exception_ptr error;
+
+        {
+            std::unique_lock<std::mutex> lock (pending->mutex);
+            pending->cv.wait(lock, [&]{
+                return pending->status == pending_load::PREPARED || pending->status == pending_load::DONE;
+            });
+            if (pending->status == pending_load::DONE && !pending->error) {
+                return pending->result;
+            }
+            error = pending->error;
+            if (!error) {
+                pending->status = pending_load::FINISHING;
+                finish = std::move(pending->finish);
+            }
+        }
+
+        // A failed load is forgotten, so the next request tries again.
+        if (!error) {
+            auto start = std::chrono::steady_clock::now() - pending->prepare_time;
+            try {
+                ptr = finish();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            add_load_time(start);
+        }
+
+        publish(h, *pending, ptr, error);
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
+        return ptr;
+    }
+
+    // Stores the result of a load, unless the cache was cleared while it was in flight, and wakes its waiters.
+    void publish(resource_handle h, pending_load& pending, const std::shared_ptr<T>& ptr, std::exception_ptr error) {
+        auto bytes = measure(ptr);
+        {
+            auto& sh = get_shard(h);
+            std::lock_guard<std::mutex> lock (sh.mutex);
+            auto& slot = sh.slots[h.index / NUM_SHARDS];
+            if (slot.pending.get() == &pending) {
+                slot.pending = nullptr;
+                if (!error) {
+                    slot.ptr = ptr;
+                    slot.bytes = bytes;
+                    slot.last_use = ++use_clock;
+                    resident_bytes += bytes;
+                }
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock (pending.mutex);
+            pending.result = ptr;
+            pending.error = error;
+            pending.status = pending_load::DONE;
+        }
+        pending.cv.notify_all();
+        schedule_trim();
+    }
+
+    // Loads finish on whichever thread asked for them, so eviction waits for the main thread.
+    // Requests made before it runs share one trim.
+    void schedule_trim() {
+        std::size_t limit = budget;
+
+        if (limit == 0 || resident_bytes <= limit || trim_scheduled.exchange(true)) {
+            return;
+        }
+
+        async_loader::run_on_main([this]{
+            trim_scheduled = false;
+            trim();
+        });
+    }
+
+    std::size_t measure(const std::shared_ptr<T>& ptr) const {
+        return sizer && ptr ? sizer(*ptr) : 0;
+    }
+
+    void add_load_time(std::chrono::steady_clock::time_point start) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        load_microseconds += std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    }
+
     factory_function factory;
-    std::map<std::tuple<S...>, std::shared_ptr<T>> cache;
+    prepare_function prepare;
+    size_function sizer;
+    std::array<shard, NUM_SHARDS> shards;
+
+    std::atomic<std::size_t> budget {0};
+    std::atomic<std::size_t> resident_bytes {0};
+    std::atomic<std::uint64_t> use_clock {0};
+    std::atomic<std::uint64_t> hits {0};
+    std::atomic<std::uint64_t> misses {0};
+    std::atomic<std::uint64_t> evictions {0};
+    std::atomic<std::uint64_t> load_microseconds {0};
+    std::atomic<bool> trim_scheduled {false};
 };
 
-#endif //LD40_RESOURCE_CACHE_HPP
+template <typename T, typename... S>
+constexpr int resource_cache<T, S...>::NUM_SHARDS;
 
+#endif //LD40_RESOURCE_CACHE_HPP
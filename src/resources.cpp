@@ -1,52 +1,164 @@
 #include "resources.hpp"
 
+#include "assets.hpp"
+#include "timeline.hpp"
+
+#include <lodepng.h>
+
 #include <iostream>
 
 namespace resources {
 
-resource_cache<sushi::texture_2d, std::string> textures ([](const std::string& name) {
+namespace {
+
+// Compact samples are opted into with "compact_samples" in meta/sfx.json.
+bool use_compact_samples() {
+    static const bool compact = [] {
+        auto json = assets::load_json("meta/sfx.json");
+        return json.is_object() && json.count("compact_samples") && json["compact_samples"].get<bool>();
+    }();
+    return compact;
+}
+
+template <typename T, typename... S>
+void log_cache_stats(const char* name, const resource_cache<T, S...>& cache) {
+    auto stats = cache.get_stats();
+    std::clog << "    " << name << ": " << stats.hits << " hits, " << stats.misses << " misses, "
+        << stats.evictions << " evictions, " << stats.load_seconds << " s loading, "
+        << stats.resident_bytes / 1024 << " KiB resident";
+    if (stats.budget_bytes > 0) {
+        std::clog << " of " << stats.budget_bytes / 1024 << " KiB";
+    }
+    std::clog << std::endl;
+}
+
+} //static
+
+resource_cache<sushi::texture_2d, std::string> textures (async_factory, [](const std::string& name) {
     std::clog << "Loading texture: " << name << std::endl;
-    return sushi::load_texture_2d("data/textures/"+name+".png", false, false, false, false);
+    timeline::scope timer ("decode texture " + name);
+    auto png = assets::load("textures/"+name+".png");
+    std::vector<unsigned char> pixels;
+    unsigned width = 0, height = 0;
+    if (!png || lodepng::decode(pixels, width, height, png.data(), png.size()) != 0) {
+        std::clog << "resources: Warning: Unable to load texture \"" << name << "\"." << std::endl;
+        pixels.clear();
+    }
+    return [name, pixels=std::move(pixels), width, height] {
+        timeline::scope timer ("upload texture " + name);
+        if (pixels.empty()) {
+            return std::make_shared<sushi::texture_2d>();
+        }
+        return std::make_shared<sushi::texture_2d>(
+            sushi::create_texture_2d(&pixels[0], width, height, false, false, false, false));
+    };
+}, [](const sushi::texture_2d& texture) {
+    return std::size_t(texture.width) * texture.height * 4;
 });
 
+// Decoding and packing happen on a worker, only the page uploads need the main thread.
+resource_cache<texture_atlas, std::string> atlases (async_factory, [](const std::string& name) {
+    std::clog << "Loading atlas: " << name << std::endl;
+    timeline::scope timer ("pack atlas " + name);
+    auto atlas = std::make_shared<texture_atlas>(assets::load_json("textures/"+name+".json"));
+    return [name, atlas] {
+        timeline::scope timer ("upload atlas " + name);
+        atlas->upload();
+        return atlas;
+    };
+});
+
+texture_region sprite_texture(const std::string& name) {
+    if (auto region = atlases.get("atlas")->find(name)) {
+        return *region;
+    }
+    return whole_texture(textures.get(name));
+}
+
 resource_cache<sushi::static_mesh, std::string> meshes ([](const std::string& name) {
     std::clog << "Loading static mesh: " << name << std::endl;
+    timeline::scope timer ("mesh " + name);
     return sushi::load_static_mesh_file("data/models/"+name+".obj");
 });
 
-resource_cache<SoLoud::Wav, std::string> wavs ([](const std::string& name) {
+// Decoding doesn't touch the audio engine, so the whole load can happen on a worker.
+resource_cache<sound_clip, std::string> wavs (async_factory, [](const std::string& name) {
     std::clog << "Loading WAV: " << name << std::endl;
-    auto wav = std::make_shared<SoLoud::Wav>();
-    wav->load(("data/sfx/"+name+".wav").c_str());
-    return wav;
+    timeline::scope timer ("decode wav " + name);
+    auto path = "sfx/"+name+".wav";
+    auto clip = std::make_shared<sound_clip>();
+    if (clip->load(assets::load(path), use_compact_samples()) != SoLoud::SO_NO_ERROR) {
+        std::clog << "resources: Warning: Unable to load sound \"" << path << "\"." << std::endl;
+    }
+    return [clip]{ return clip; };
+}, [](const sound_clip& clip) {
+    return clip.get_resident_bytes();
 });
 
-resource_cache<animated_sprite, std::string> animated_sprites ([](const std::string& name) {
+resource_cache<animated_sprite, std::string> animated_sprites (async_factory, [](const std::string& name) {
     std::clog << "Loading anim: " << name << std::endl;
-    auto texture = textures.get(name);
-    std::ifstream jsonfile ("data/anims/"+name+".json");
-    nlohmann::json json;
-    jsonfile >> json;
-    return animated_sprite(json, texture);
+    timeline::scope timer ("parse anim " + name);
+    auto json = assets::load("anims/"+name+".json");
+    if (!json) {
+        std::clog << "resources: Warning: Unable to load anim \"" << name << "\"." << std::endl;
+    }
+    auto data = read_animated_sprite_json(json.begin_chars(), json.end_chars());
+    return [name, data=std::move(data)] {
+        return std::make_shared<animated_sprite>(data, sprite_texture(name));
+    };
 });
 
 resource_cache<spritesheet, std::string, int, int> spritesheets ([](const std::string& name, int w, int h) {
     std::clog << "Loading sheet: (" << name << ", " << w << ", " << h << ")" << std::endl;
-    auto texture = textures.get(name);
-    return spritesheet(texture, w, h);
+    timeline::scope timer ("sheet " + name);
+    auto region = sprite_texture(name);
+    return spritesheet(region, w, h);
 });
 
 resource_cache<msdf_font, std::string> fonts ([](const std::string& name) {
     std::clog << "Loading font: " << name << std::endl;
+    timeline::scope timer ("font " + name);
     return msdf_font(name);
 });
 
-resource_cache<SoLoud::Wav, std::string> musics ([](const std::string& name) {
+resource_cache<stage_data, std::string> stages ([](const std::string& name) {
+    std::clog << "Loading stage: " << name << std::endl;
+    timeline::scope timer ("stage " + name);
+    stage_data stage;
+    if (!load_stage(name, stage)) {
+        std::clog << "resources: Warning: Unable to load stage \"" << name << "\"." << std::endl;
+    }
+    return stage;
+});
+
+// Only the compressed file is kept. Decoding happens while it plays, on the stream's own thread.
+resource_cache<buffered_stream, std::string> musics (async_factory, [](const std::string& name) {
     std::clog << "Loading music: " << name << std::endl;
-    auto wav = std::make_shared<SoLoud::Wav>();
-    wav->load(("data/music/"+name+".ogg").c_str());
-    wav->setLooping(1);
-    return wav;
+    timeline::scope timer ("open music " + name);
+    auto stream = std::make_shared<buffered_stream>();
+    if (stream->load(assets::load("music/"+name+".ogg")) != SoLoud::SO_NO_ERROR) {
+        std::clog << "resources: Warning: Unable to load music \"" << name << "\"." << std::endl;
+    }
+    stream->setLooping(1);
+    return [stream]{ return stream; };
+}, [](const buffered_stream& stream) {
+    return stream.get_resident_bytes();
 });
 
+void log_stats() {
+    std::clog << "Resource caches:" << std::endl;
+    log_cache_stats("textures", textures);
+    log_cache_stats("atlases", atlases);
+    log_cache_stats("meshes", meshes);
+    log_cache_stats("wavs", wavs);
+    if (auto saved = sound_clip::get_total_saved_bytes()) {
+        std::clog << "        compact samples save " << saved / 1024 << " KiB" << std::endl;
+    }
+    log_cache_stats("musics", musics);
+    log_cache_stats("animated_sprites", animated_sprites);
+    log_cache_stats("spritesheets", spritesheets);
+    log_cache_stats("fonts", fonts);
+    log_cache_stats("stages", stages);
+}
+
 } //namespace resources
@@ -4,12 +4,14 @@
 #include "resource_cache.hpp"
 #include "animated_sprite.hpp"
 #include "spritesheet.hpp"
+#include "texture_atlas.hpp"
 #include "font.hpp"
+#include "stage.hpp"
+#include "buffered_stream.hpp"
+#include "sound_clip.hpp"
 
 #include <sushi/texture.hpp>
 #include <sushi/mesh.hpp>
-#include <soloud_wav.h>
-#include <soloud_wavstream.h>
 
 #include <string>
 #include <tuple>
@@ -18,11 +20,18 @@ namespace resources {
 
 extern resource_cache<sushi::texture_2d, std::string> textures;
 
+extern resource_cache<texture_atlas, std::string> atlases;
+
+// The named texture's region in the sprite atlas, or the whole texture if it isn't packed.
+texture_region sprite_texture(const std::string& name);
+
 extern resource_cache<sushi::static_mesh, std::string> meshes;
 
-extern resource_cache<SoLoud::Wav, std::string> wavs;
+// Decoded up front. Compact if meta/sfx.json sets "compact_samples".
+extern resource_cache<sound_clip, std::string> wavs;
 
-extern resource_cache<SoLoud::Wav, std::string> musics;
+// Streamed, so only the compressed file stays in memory.
+extern resource_cache<buffered_stream, std::string> musics;
 
 extern resource_cache<animated_sprite, std::string> animated_sprites;
 
@@ -30,6 +39,13 @@ extern resource_cache<spritesheet, std::string, int, int> spritesheets;
 
 extern resource_cache<msdf_font, std::string> fonts;
 
+// Stages are small and don't touch OpenGL, so they can be requested from any thread.
+// A missing stage loads as an empty 1x1 map.
+extern resource_cache<stage_data, std::string> stages;
+
+// Writes each cache's hit, miss, eviction, load time and memory statistics to the log.
+void log_stats();
+
 } //namespace resources
 
 #endif //LD40_RESOURCES_HPP
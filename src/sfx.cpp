@@ -0,0 +1,168 @@
+#include "sfx.hpp"
+
+#include "assets.hpp"
+#include "resources.hpp"
+#include "soloud.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace sfx {
+
+namespace {
+
+struct sound_info {
+    resource_handle wav;
+    int priority = 0;
+    int cooldown = 0;
+    int last_played = std::numeric_limits<int>::min() / 2;
+};
+
+struct request {
+    sound_info* sound;
+    float volume;
+};
+
+struct voice {
+    SoLoud::handle handle;
+    int priority;
+    float volume;
+};
+
+// Higher priority first, then louder.
+bool outranks(int priority_a, float volume_a, int priority_b, float volume_b) {
+    return priority_a != priority_b ? priority_a > priority_b : volume_a > volume_b;
+}
+
+struct mixer_state {
+    int voice_budget = 8;
+    int tick = 0;
+    nlohmann::json settings;
+    std::unordered_map<std::string, sound_info> sounds;
+    std::vector<request> pending;
+    std::vector<voice> voices;
+    counters stats;
+
+    mixer_state() {
+        settings = assets::load_json("meta/sfx.json");
+        if (settings.is_object() && settings.count("voice_budget")) {
+            voice_budget = settings["voice_budget"];
+        }
+    }
+
+    // Sounds not listed in meta/sfx.json get priority 0 and no cooldown.
+    sound_info& get_sound(const std::string& name) {
+        auto iter = sounds.find(name);
+        if (iter != end(sounds)) {
+            return iter->second;
+        }
+
+        sound_info info;
+        info.wav = resources::wavs.intern(name);
+        if (settings.is_object() && settings.count("sounds") && settings["sounds"].count(name)) {
+            auto& json = settings["sounds"][name];
+            if (json.count("priority")) {
+                info.priority = json["priority"];
+            }
+            if (json.count("cooldown")) {
+                info.cooldown = json["cooldown"];
+            }
+        }
+
+        return sounds.emplace(name, info).first->second;
+    }
+};
+
+mixer_state& get_state() {
+    static mixer_state state;
+    return state;
+}
+
+} //static
+
+void play(const std::string& name, float volume) {
+    auto& state = get_state();
+    auto& sound = state.get_sound(name);
+
+    ++state.stats.requested;
+
+    for (auto& r : state.pending) {
+        if (r.sound == &sound) {
+            r.volume = std::max(r.volume, volume);
+            ++state.stats.coalesced;
+            return;
+        }
+    }
+
+    state.pending.push_back({&sound, volume});
+}
+
+void update() {
+    auto& state = get_state();
+    ++state.tick;
+
+    if (state.pending.empty()) {
+        return;
+    }
+
+    auto& voices = state.voices;
+    voices.erase(std::remove_if(begin(voices), end(voices), [](const voice& v) {
+        return !g_soloud->isValidVoiceHandle(v.handle);
+    }), end(voices));
+
+    std::sort(begin(state.pending), end(state.pending), [](const request& a, const request& b) {
+        return outranks(a.sound->priority, a.volume, b.sound->priority, b.volume);
+    });
+
+    for (auto& r : state.pending) {
+        auto& sound = *r.sound;
+
+        if (state.tick - sound.last_played < sound.cooldown) {
+            ++state.stats.cooling_down;
+            continue;
+        }
+
+        if (int(voices.size()) >= state.voice_budget) {
+            auto lowest = std::min_element(begin(voices), end(voices), [](const voice& a, const voice& b) {
+                return outranks(b.priority, b.volume, a.priority, a.volume);
+            });
+            if (lowest == end(voices) || !outranks(sound.priority, r.volume, lowest->priority, lowest->volume)) {
+                ++state.stats.over_budget;
+                continue;
+            }
+            g_soloud->stop(lowest->handle);
+            voices.erase(lowest);
+            ++state.stats.preempted;
+        }
+
+        auto handle = g_soloud->play(*resources::wavs.get(sound.wav), r.volume);
+        voices.push_back({handle, sound.priority, r.volume});
+        sound.last_played = state.tick;
+        ++state.stats.played;
+    }
+
+    state.pending.clear();
+}
+
+void stop_all() {
+    auto& state = get_state();
+    g_soloud->stopAll();
+    state.pending.clear();
+    state.voices.clear();
+}
+
+counters get_counters() {
+    return get_state().stats;
+}
+
+void log_stats() {
+    auto c = get_counters();
+    std::clog << "Sound effects: " << c.requested << " requested, " << c.coalesced << " coalesced, "
+        << c.cooling_down << " cooling down, " << c.over_budget << " over budget, "
+        << c.preempted << " preempted, " << c.played << " played" << std::endl;
+}
+
+} //namespace sfx
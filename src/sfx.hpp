@@ -0,0 +1,40 @@
+#ifndef LD40_SFX_HPP
+#define LD40_SFX_HPP
+
+#include <cstdint>
+#include <string>
+
+// Sound effects go through here instead of straight to SoLoud, so a crowd of collisions can't flood the mixer.
+// Requests are queued and played once per tick by update():
+//  - identical requests within a tick are coalesced into one, at the loudest volume,
+//  - a sound doesn't replay until its cooldown has passed,
+//  - at most voice_budget effects play at once. When full, a new sound takes the voice of the lowest ranked one
+//    if it outranks it by priority, then volume, and is dropped otherwise.
+// Priorities, cooldowns (in ticks) and the budget are read from meta/sfx.json.
+namespace sfx {
+
+struct counters {
+    std::uint64_t requested = 0;
+    std::uint64_t coalesced = 0; // Merged into another request in the same tick
+    std::uint64_t cooling_down = 0; // Dropped because the sound played too recently
+    std::uint64_t over_budget = 0; // Dropped because every voice was busy with higher ranked sounds
+    std::uint64_t preempted = 0; // Playing voices stopped to make room
+    std::uint64_t played = 0;
+};
+
+void play(const std::string& name, float volume = 1);
+
+// Plays this tick's requests. Called once per frame by the main loop.
+void update();
+
+// Stops every sound, including music, and drops queued requests.
+void stop_all();
+
+counters get_counters();
+
+// Writes the counters to the log.
+void log_stats();
+
+} //namespace sfx
+
+#endif //LD40_SFX_HPP
@@ -0,0 +1,83 @@
+#include "skyline_packer.hpp"
+
+#include <algorithm>
+#include <limits>
+
+skyline_packer::skyline_packer(int width, int height) :
+    skyline{{0, 0, width}},
+    width(width),
+    height(height)
+{}
+
+bool skyline_packer::fit(int i, int w, int h, int& y) const {
+    if (skyline[i].x + w > width) {
+        return false;
+    }
+
+    y = skyline[i].y;
+    auto remaining = w;
+
+    for (auto j = i; remaining > 0; ++j) {
+        y = std::max(y, skyline[j].y);
+        if (y + h > height) {
+            return false;
+        }
+        remaining -= skyline[j].width;
+    }
+
+    return true;
+}
+
+bool skyline_packer::pack(int w, int h, int& x, int& y) {
+    auto best = -1;
+    auto best_top = std::numeric_limits<int>::max();
+    auto best_width = std::numeric_limits<int>::max();
+
+    for (auto i = 0; i < int(skyline.size()); ++i) {
+        int top;
+        if (fit(i, w, h, top)) {
+            if (top + h < best_top || (top + h == best_top && skyline[i].width < best_width)) {
+                best = i;
+                best_top = top + h;
+                best_width = skyline[i].width;
+                x = skyline[i].x;
+                y = top;
+            }
+        }
+    }
+
+    if (best == -1) {
+        return false;
+    }
+
+    skyline.insert(skyline.begin() + best, segment{x, y + h, w});
+
+    // Shrink or remove the segments now covered by the new one.
+    for (auto i = best + 1; i < int(skyline.size()); ++i) {
+        auto& prev = skyline[i - 1];
+        auto& cur = skyline[i];
+        auto overlap = prev.x + prev.width - cur.x;
+        if (overlap <= 0) {
+            break;
+        }
+        cur.x += overlap;
+        cur.width -= overlap;
+        if (cur.width <= 0) {
+            skyline.erase(skyline.begin() + i);
+            --i;
+        } else {
+            break;
+        }
+    }
+
+    // Merge neighbors at the same height.
+    for (auto i = 0; i + 1 < int(skyline.size()); ++i) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+            --i;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,31 @@
+#ifndef LD40_SKYLINE_PACKER_HPP
+#define LD40_SKYLINE_PACKER_HPP
+
+#include <vector>
+
+// Skyline bottom-left rectangle packer.
+// A default-constructed packer has no room at all.
+class skyline_packer {
+public:
+    skyline_packer() = default;
+
+    skyline_packer(int width, int height);
+
+    // Finds room for a w*h rectangle. Returns false if it doesn't fit.
+    bool pack(int w, int h, int& x, int& y);
+
+private:
+    struct segment {
+        int x;
+        int y;
+        int width;
+    };
+
+    bool fit(int i, int w, int h, int& y) const;
+
+    std::vector<segment> skyline;
+    int width = 0;
+    int height = 0;
+};
+
+#endif //LD40_SKYLINE_PACKER_HPP
@@ -0,0 +1,141 @@
+#include "sound_clip.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+
+std::atomic<std::size_t> total_saved_bytes {0};
+
+// The same scale the WAV decoder uses, so 16-bit files round-trip exactly.
+std::int16_t to_pcm16(float x) {
+    return std::int16_t(std::min(std::max(std::lrint(x * 32768.f), -32768l), 32767l));
+}
+
+} //static
+
+// Mirrors SoLoud::WavInstance, but converts each sample to float as it is copied out.
+class sound_clip_instance : public SoLoud::AudioSourceInstance {
+public:
+    explicit sound_clip_instance(const sound_clip& parent) : parent(parent) {}
+
+    void getAudio(float* buffer, unsigned int samples) override {
+        auto count = parent.sample_count;
+        auto written = 0u;
+
+        while (written < samples) {
+            auto n = std::min(samples - written, count - std::min(offset, count));
+
+            for (auto ch = 0u; ch < mChannels; ++ch) {
+                auto src = parent.samples.data() + std::size_t(ch) * count + offset;
+                auto dst = buffer + ch * samples + written;
+                for (auto i = 0u; i < n; ++i) {
+                    dst[i] = src[i] * (1.f / 32768.f);
+                }
+            }
+
+            written += n;
+            offset += n;
+
+            if (offset >= count) {
+                if ((mFlags & LOOPING) && count > 0) {
+                    offset = 0;
+                    ++mLoopCount;
+                } else {
+                    for (auto ch = 0u; ch < mChannels; ++ch) {
+                        std::fill(buffer + ch * samples + written, buffer + (ch + 1) * samples, 0.f);
+                    }
+                    offset += samples - written;
+                    written = samples;
+                }
+            }
+        }
+    }
+
+    SoLoud::result rewind() override {
+        offset = 0;
+        mStreamTime = 0;
+        return SoLoud::SO_NO_ERROR;
+    }
+
+    bool hasEnded() override {
+        return !(mFlags & LOOPING) && offset >= parent.sample_count;
+    }
+
+private:
+    const sound_clip& parent;
+    unsigned offset = 0;
+};
+
+sound_clip::~sound_clip() {
+    // Instances read from `samples`, so they must go first.
+    stop();
+    if (is_compact()) {
+        total_saved_bytes -= samples.size() * (sizeof(float) - sizeof(std::int16_t));
+    }
+}
+
+SoLoud::result sound_clip::load(const assets::blob& bytes, bool compact) {
+    stop();
+    if (is_compact()) {
+        total_saved_bytes -= samples.size() * (sizeof(float) - sizeof(std::int16_t));
+    }
+    samples = {};
+    sample_count = 0;
+    wav = nullptr;
+
+    if (!bytes) {
+        return SoLoud::FILE_NOT_FOUND;
+    }
+
+    // Wav decodes everything up front, so it never needs the file's bytes again.
+    auto decoded = std::make_unique<SoLoud::Wav>();
+    auto result = decoded->loadMem(const_cast<unsigned char*>(bytes.data()), bytes.size(), false, false);
+    mChannels = decoded->mChannels;
+    mBaseSamplerate = decoded->mBaseSamplerate;
+
+    if (result == SoLoud::SO_NO_ERROR && compact && decoded->mSampleCount > 0) {
+        sample_count = decoded->mSampleCount;
+        samples.resize(std::size_t(sample_count) * mChannels);
+        std::transform(decoded->mData, decoded->mData + samples.size(), samples.begin(), to_pcm16);
+        total_saved_bytes += samples.size() * (sizeof(float) - sizeof(std::int16_t));
+    } else {
+        wav = std::move(decoded);
+    }
+
+    return result;
+}
+
+SoLoud::AudioSourceInstance* sound_clip::createInstance() {
+    if (wav) {
+        return wav->createInstance();
+    }
+    // Compact, or never loaded, which plays as silence.
+    return new sound_clip_instance(*this);
+}
+
+SoLoud::time sound_clip::getLength() {
+    if (wav) {
+        return wav->getLength();
+    }
+    return mBaseSamplerate > 0 ? sample_count / mBaseSamplerate : 0;
+}
+
+bool sound_clip::is_compact() const {
+    return !samples.empty();
+}
+
+std::size_t sound_clip::get_resident_bytes() const {
+    if (is_compact()) {
+        return samples.size() * sizeof(std::int16_t);
+    }
+    if (wav) {
+        return std::size_t(wav->mSampleCount) * wav->mChannels * sizeof(float);
+    }
+    return 0;
+}
+
+std::size_t sound_clip::get_total_saved_bytes() {
+    return total_saved_bytes;
+}
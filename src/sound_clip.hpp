@@ -0,0 +1,46 @@
+#ifndef LD40_SOUND_CLIP_HPP
+#define LD40_SOUND_CLIP_HPP
+
+#include "assets.hpp"
+
+#include <soloud.h>
+#include <soloud_wav.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class sound_clip_instance;
+
+// A fully decoded sound, like SoLoud::Wav.
+// Compact clips keep their samples as 16-bit PCM, half the size of Wav's floats,
+// and convert them to float as the mixer reads them.
+class sound_clip : public SoLoud::AudioSource {
+public:
+    sound_clip() = default;
+    ~sound_clip() override;
+
+    // Decodes the file. Returns a SoLoud error code.
+    SoLoud::result load(const assets::blob& bytes, bool compact);
+
+    SoLoud::AudioSourceInstance* createInstance() override;
+
+    SoLoud::time getLength();
+
+    bool is_compact() const;
+
+    std::size_t get_resident_bytes() const;
+
+    // Bytes all live compact clips save over keeping their samples as floats.
+    static std::size_t get_total_saved_bytes();
+
+private:
+    friend class sound_clip_instance;
+
+    std::unique_ptr<SoLoud::Wav> wav; // Null when compact
+    std::vector<std::int16_t> samples; // Planar, like Wav::mData
+    unsigned sample_count = 0; // Per channel
+};
+
+#endif //LD40_SOUND_CLIP_HPP
@@ -0,0 +1,231 @@
+#include "sprite_batch.hpp"
+
+#include <cstddef>
+
+namespace {
+
+#ifdef __EMSCRIPTEN__
+// Attribute locations of the expanded vertices.
+enum attrib {
+    POSITION = 0,
+    TEXCOORD = 1,
+    VERTEX_TINT = 2
+};
+
+const auto batchVertexSource = R"(
+    attribute vec2 position;
+    attribute vec2 texcoord;
+    attribute vec4 tint;
+    varying vec2 v_texcoord;
+    varying vec4 v_tint;
+    uniform mat4 MVP;
+    void main()
+    {
+        v_texcoord = texcoord;
+        v_tint = tint;
+        gl_Position = MVP * vec4(position, 0.0, 1.0);
+    }
+)";
+
+const auto batchFragmentSource = R"(
+    precision mediump float;
+    varying vec2 v_texcoord;
+    varying vec4 v_tint;
+    uniform sampler2D s_texture;
+    void main()
+    {
+        gl_FragColor = texture2D(s_texture, v_texcoord) * v_tint;
+    }
+)";
+#else
+// Attribute locations of the shared quad and the per-instance data.
+enum attrib {
+    CORNER = 0,
+    RECT = 1,
+    UV_RECT = 2,
+    TINT = 3
+};
+
+const auto batchVertexSource = R"(#version 400
+    layout(location = 0) in vec2 corner;
+    layout(location = 1) in vec4 rect;
+    layout(location = 2) in vec4 uv_rect;
+    layout(location = 3) in vec4 tint;
+    out vec2 v_texcoord;
+    out vec4 v_tint;
+    uniform mat4 MVP;
+    void main()
+    {
+        v_texcoord = vec2(mix(uv_rect.x, uv_rect.z, corner.x), mix(uv_rect.w, uv_rect.y, corner.y));
+        v_tint = tint;
+        gl_Position = MVP * vec4(rect.xy + corner * rect.zw, 0.0, 1.0);
+    }
+)";
+
+const auto batchFragmentSource = R"(#version 400
+    in vec2 v_texcoord;
+    in vec4 v_tint;
+    uniform sampler2D s_texture;
+    layout(location = 0) out vec4 color;
+    void main()
+    {
+        color = texture(s_texture, v_texcoord) * v_tint;
+    }
+)";
+#endif
+
+// Corners of the two triangles of a quad, in the same winding as the spritesheet meshes.
+const glm::vec2 quad_corners[6] = {{0,0},{0,1},{1,1},{1,1},{1,0},{0,0}};
+
+sushi::unique_program link_batch_program() {
+    return sushi::link_program({
+        sushi::compile_shader(sushi::shader_type::VERTEX, {batchVertexSource}),
+        sushi::compile_shader(sushi::shader_type::FRAGMENT, {batchFragmentSource}),
+#ifdef __EMSCRIPTEN__
+    }, {
+        {POSITION, "position"},
+        {TEXCOORD, "texcoord"},
+        {VERTEX_TINT, "tint"},
+#endif
+    });
+}
+
+} //static
+
+void expand_sprite_instances(const std::vector<sprite_instance>& instances, std::vector<sprite_vertex>& out) {
+    out.reserve(out.size() + instances.size() * 6);
+
+    for (const auto& inst : instances) {
+        for (const auto& corner : quad_corners) {
+            sprite_vertex v;
+            v.position = {inst.rect.x + corner.x * inst.rect.z, inst.rect.y + corner.y * inst.rect.w};
+            v.texcoord = {corner.x == 0 ? inst.uv.x : inst.uv.z, corner.y == 0 ? inst.uv.w : inst.uv.y};
+            v.tint = inst.tint;
+            out.push_back(v);
+        }
+    }
+}
+
+sprite_batch::sprite_batch(int capacity) :
+    instances(),
+    runs(),
+    vertices(),
+    program(link_batch_program()),
+    vao(sushi::make_unique_vertex_array()),
+    quad_buffer(),
+    stream_buffer(sushi::make_unique_buffer())
+{
+    instances.reserve(capacity);
+
+    sushi::set_program(program);
+    sushi::set_uniform("s_texture", 0);
+
+    sushi::bind_vertex_array(vao.get());
+
+#ifdef __EMSCRIPTEN__
+    vertices.reserve(capacity * 6);
+
+    glBindBuffer(GL_ARRAY_BUFFER, stream_buffer.get());
+    glEnableVertexAttribArray(POSITION);
+    glEnableVertexAttribArray(TEXCOORD);
+    glEnableVertexAttribArray(VERTEX_TINT);
+    glVertexAttribPointer(POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(sprite_vertex),
+        reinterpret_cast<const GLvoid*>(offsetof(sprite_vertex, position)));
+    glVertexAttribPointer(TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(sprite_vertex),
+        reinterpret_cast<const GLvoid*>(offsetof(sprite_vertex, texcoord)));
+    glVertexAttribPointer(VERTEX_TINT, 4, GL_FLOAT, GL_FALSE, sizeof(sprite_vertex),
+        reinterpret_cast<const GLvoid*>(offsetof(sprite_vertex, tint)));
+#else
+    quad_buffer = sushi::make_unique_buffer();
+    glBindBuffer(GL_ARRAY_BUFFER, quad_buffer.get());
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad_corners), quad_corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(CORNER);
+    glVertexAttribPointer(CORNER, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), nullptr);
+
+    glBindBuffer(GL_ARRAY_BUFFER, stream_buffer.get());
+    glEnableVertexAttribArray(RECT);
+    glEnableVertexAttribArray(UV_RECT);
+    glEnableVertexAttribArray(TINT);
+    glVertexAttribDivisor(RECT, 1);
+    glVertexAttribDivisor(UV_RECT, 1);
+    glVertexAttribDivisor(TINT, 1);
+    bind_instance_attribs(0);
+#endif
+
+    sushi::bind_vertex_array(0);
+}
+
+void sprite_batch::add(const spritesheet& sheet, int cell, glm::vec2 pos, glm::vec4 tint) {
+    auto& texture = sheet.get_texture();
+
+    if (runs.empty() || runs.back().texture != &texture) {
+        runs.push_back({&texture, int(instances.size()), 0});
+    }
+    ++runs.back().count;
+
+    // Same integer centering as the spritesheet meshes.
+    auto w = sheet.get_sprite_width();
+    auto h = sheet.get_sprite_height();
+    auto left = pos.x + float(-w/2);
+    auto bottom = pos.y + float(-h/2);
+
+    sprite_instance inst;
+    inst.rect = {left, bottom, float(w), float(h)};
+    inst.uv = sheet.get_uv_rect(cell/16, cell%16);
+    inst.tint = tint;
+    instances.push_back(inst);
+}
+
+void sprite_batch::draw(const glm::mat4& mvp) {
+    if (instances.empty()) return;
+
+    sushi::set_program(program);
+    sushi::set_uniform("MVP", mvp);
+    sushi::bind_vertex_array(vao.get());
+    glBindBuffer(GL_ARRAY_BUFFER, stream_buffer.get());
+
+#ifdef __EMSCRIPTEN__
+    vertices.clear();
+    expand_sprite_instances(instances, vertices);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(sprite_vertex), &vertices[0], GL_STREAM_DRAW);
+
+    for (const auto& r : runs) {
+        sushi::set_texture(0, *r.texture);
+        glDrawArrays(GL_TRIANGLES, r.first * 6, r.count * 6);
+    }
+#else
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(sprite_instance), &instances[0], GL_STREAM_DRAW);
+
+    // GL 4.1 has no base instance, so each run moves the instance attributes instead.
+    for (const auto& r : runs) {
+        if (runs.size() > 1) {
+            bind_instance_attribs(r.first);
+        }
+        sushi::set_texture(0, *r.texture);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, r.count);
+    }
+
+    if (runs.size() > 1) {
+        bind_instance_attribs(0);
+    }
+#endif
+
+    instances.clear();
+    runs.clear();
+}
+
+const std::vector<sprite_instance>& sprite_batch::get_instances() const {
+    return instances;
+}
+
+#ifndef __EMSCRIPTEN__
+void sprite_batch::bind_instance_attribs(int first) {
+    auto base = first * sizeof(sprite_instance);
+    glVertexAttribPointer(RECT, 4, GL_FLOAT, GL_FALSE, sizeof(sprite_instance),
+        reinterpret_cast<const GLvoid*>(base + offsetof(sprite_instance, rect)));
+    glVertexAttribPointer(UV_RECT, 4, GL_FLOAT, GL_FALSE, sizeof(sprite_instance),
+        reinterpret_cast<const GLvoid*>(base + offsetof(sprite_instance, uv)));
+    glVertexAttribPointer(TINT, 4, GL_FLOAT, GL_FALSE, sizeof(sprite_instance),
+        reinterpret_cast<const GLvoid*>(base + offsetof(sprite_instance, tint)));
+}
+#endif
@@ -0,0 +1,68 @@
+#ifndef LD40_SPRITE_BATCH_HPP
+#define LD40_SPRITE_BATCH_HPP
+
+#include "spritesheet.hpp"
+
+#include <sushi/mesh.hpp>
+#include <sushi/shader.hpp>
+#include <sushi/texture.hpp>
+
+#include <vector>
+
+// One queued sprite. The rect is {left, bottom, width, height} in world space,
+// and the UV rect is laid out like spritesheet::get_uv_rect.
+struct sprite_instance {
+    glm::vec4 rect;
+    glm::vec4 uv;
+    glm::vec4 tint;
+};
+
+// A sprite_instance expanded into triangles for the GLES2 path.
+struct sprite_vertex {
+    glm::vec2 position;
+    glm::vec2 texcoord;
+    glm::vec4 tint;
+};
+
+// Appends six vertices (two triangles) per instance.
+void expand_sprite_instances(const std::vector<sprite_instance>& instances, std::vector<sprite_vertex>& out);
+
+// Collects sprites during a frame and draws each run of sprites that share a texture with one draw call.
+// The desktop build draws the runs instanced; the Emscripten build expands them on the CPU.
+// Sprites are drawn in the order they were added.
+class sprite_batch {
+public:
+    sprite_batch() = default;
+
+    // Creates the GL objects, reserving room for `capacity` sprites. Storage grows as needed.
+    explicit sprite_batch(int capacity);
+
+    void add(const spritesheet& sheet, int cell, glm::vec2 pos, glm::vec4 tint = glm::vec4{1.f});
+
+    // Draws and clears everything added since the last draw.
+    void draw(const glm::mat4& mvp);
+
+    // Sprites queued since the last draw.
+    const std::vector<sprite_instance>& get_instances() const;
+
+private:
+    struct run {
+        const sushi::texture_2d* texture;
+        int first;
+        int count;
+    };
+
+    // Points the per-instance attributes at the instance buffer, starting at `first`. Desktop only.
+    void bind_instance_attribs(int first);
+
+    std::vector<sprite_instance> instances;
+    std::vector<run> runs;
+    std::vector<sprite_vertex> vertices;
+
+    sushi::unique_program program;
+    sushi::unique_vertex_array vao;
+    sushi::unique_buffer quad_buffer;
+    sushi::unique_buffer stream_buffer;
+};
+
+#endif //LD40_SPRITE_BATCH_HPP
@@ -1,48 +1,76 @@
 #include "spritesheet.hpp"
 
 spritesheet::spritesheet(std::shared_ptr<sushi::texture_2d> tex, int w, int h) :
-    texture(std::move(tex)),
-    meshes(),
+    spritesheet(whole_texture(std::move(tex)), w, h)
+{}
+
+spritesheet::spritesheet(texture_region reg, int w, int h) :
+    texture(),
+    region(std::move(reg)),
+    mesh(),
     sprite_width(w),
     sprite_height(h),
     num_rows(),
     num_cols()
 {
-    num_rows = texture->height / sprite_height;
-    num_cols = texture->width / sprite_width;
+    texture = region.texture;
 
-    auto rowstride = float(sprite_height) / float(texture->height);
-    auto colstride = float(sprite_width) / float(texture->width);
+    num_rows = region.height / sprite_height;
+    num_cols = region.width / sprite_width;
 
     auto left = -sprite_width/2;
     auto right = left + sprite_width;
     auto bottom = -sprite_height/2;
     auto top = bottom + sprite_height;
 
-    for (auto r = 0; r < num_rows; ++r) {
-        auto uvbottom = r * rowstride;
-        auto uvtop = (r + 1) * rowstride;
+    if (num_rows <= 0 || num_cols <= 0) return;
+
+    // Every cell shares the same four positions, only the texcoords differ.
+    std::vector<glm::vec3> positions = {{left, bottom, 0.f},{left, top, 0.f},{right, top, 0.f},{right, bottom, 0.f}};
+    std::vector<glm::vec2> texcoords;
+    std::vector<sushi::Tri> tris;
 
+    for (auto r = 0; r < num_rows; ++r) {
         for (auto c = 0; c < num_cols; ++c) {
-            auto uvleft = c * colstride;
-            auto uvright = (c + 1) * colstride;
-
-            meshes.emplace_back(sushi::load_static_mesh_data(
-                {{left, bottom, 0.f},{left, top, 0.f},{right, top, 0.f},{right, bottom, 0.f}},
-                {{0.f, 0.f, 1.f},{0.f, 0.f, 1.f},{0.f, 0.f, 1.f},{0.f, 0.f, 1.f}},
-                {{uvleft, uvtop},{uvleft, uvbottom},{uvright, uvbottom},{uvright, uvtop}},
-                {{{{0,0,0},{1,1,1},{2,2,2}}},{{{2,2,2},{3,3,3},{0,0,0}}}}
-            ));
+            auto uv = get_uv_rect(r, c);
+            auto uvleft = uv.x;
+            auto uvbottom = uv.y;
+            auto uvright = uv.z;
+            auto uvtop = uv.w;
+
+            auto base = sushi::Tri::Index2(texcoords.size());
+            texcoords.insert(texcoords.end(), {{uvleft, uvtop},{uvleft, uvbottom},{uvright, uvbottom},{uvright, uvtop}});
+            tris.push_back({{{0,0,base+0},{1,0,base+1},{2,0,base+2}}});
+            tris.push_back({{{2,0,base+2},{3,0,base+3},{0,0,base+0}}});
         }
     }
+
+    mesh = sushi::load_static_mesh_data(positions, {{0.f, 0.f, 1.f}}, texcoords, tris);
 }
 
 const sushi::texture_2d& spritesheet::get_texture() const {
     return *texture;
 }
 
-const sushi::static_mesh& spritesheet::get_mesh(int r, int c) const {
-    return meshes[r * get_num_cols() + c];
+sushi::static_mesh_slice spritesheet::get_mesh(int r, int c) const {
+    sushi::static_mesh_slice slice;
+    slice.mesh = &mesh;
+    slice.first_triangle = (r * num_cols + c) * 2;
+    slice.num_triangles = 2;
+    return slice;
+}
+
+glm::vec4 spritesheet::get_uv_rect(int r, int c) const {
+    // Same cell lookup as get_mesh, so columns past the end wrap onto the next row.
+    auto cell = r * num_cols + c;
+    r = cell / num_cols;
+    c = cell % num_cols;
+
+    auto texwidth = float(texture->width);
+    auto texheight = float(texture->height);
+    auto x = region.x + c * sprite_width;
+    auto y = region.y + r * sprite_height;
+    return {x / texwidth, y / texheight, (x + sprite_width) / texwidth, (y + sprite_height) / texheight};
 }
 
 int spritesheet::get_sprite_width() const {
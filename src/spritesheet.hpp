@@ -1,11 +1,12 @@
 #ifndef LD40_SPRITESHEET_HPP
 #define LD40_SPRITESHEET_HPP
 
+#include "texture_atlas.hpp"
+
 #include <sushi/mesh.hpp>
 #include <sushi/texture.hpp>
 
 #include <memory>
-#include <vector>
 
 class spritesheet {
 public:
@@ -13,9 +14,16 @@ public:
 
     spritesheet(std::shared_ptr<sushi::texture_2d> tex, int w, int h);
 
+    // Cells are cut from the region only, which may be part of an atlas page.
+    spritesheet(texture_region reg, int w, int h);
+
     const sushi::texture_2d& get_texture() const;
 
-    const sushi::static_mesh& get_mesh(int r, int c) const;
+    // All cells share one vertex buffer; each cell is a two-triangle slice of it.
+    sushi::static_mesh_slice get_mesh(int r, int c) const;
+
+    // Texture coordinates of a cell as {left, bottom, right, top}, where bottom is the cell's first texel row.
+    glm::vec4 get_uv_rect(int r, int c) const;
 
     int get_sprite_width() const;
 
@@ -27,7 +35,8 @@ public:
 
 private:
     std::shared_ptr<sushi::texture_2d> texture;
-    std::vector<sushi::static_mesh> meshes;
+    texture_region region;
+    sushi::static_mesh mesh;
     int sprite_width = 0;
     int sprite_height = 0;
     int num_rows = 0;
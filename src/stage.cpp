@@ -0,0 +1,242 @@
+#include "stage.hpp"
+
+#include "assets.hpp"
+#include "json_reader.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+constexpr char MAGIC[4] = {'L', 'D', 'S', 'T'};
+constexpr std::int32_t VERSION = 1;
+
+struct file_header {
+    char magic[4];
+    std::int32_t version;
+    std::int32_t num_rows;
+    std::int32_t num_cols;
+    std::int32_t time_limit;
+    std::int32_t spawn_r;
+    std::int32_t spawn_c;
+    std::int32_t num_elves;
+    std::int32_t num_beers;
+};
+
+struct file_cell {
+    std::int32_t r;
+    std::int32_t c;
+};
+
+void read_cells(json_reader& in, std::vector<stage_data::cell>& out) {
+    out.clear();
+    in.read_array([&]{
+        stage_data::cell cell = {0, 0};
+        int i = 0;
+        in.read_array([&]{
+            auto v = in.read_int();
+            if (i == 0) cell.r = v;
+            else if (i == 1) cell.c = v;
+            ++i;
+        });
+        out.push_back(cell);
+    });
+}
+
+bool read_cells(const unsigned char*& ptr, const unsigned char* end, int count, std::vector<stage_data::cell>& out) {
+    if (count < 0 || std::size_t(end - ptr) / sizeof(file_cell) < std::size_t(count)) {
+        return false;
+    }
+    out.resize(count);
+    for (auto& cell : out) {
+        file_cell fc;
+        std::memcpy(&fc, ptr, sizeof(fc));
+        ptr += sizeof(fc);
+        cell = {fc.r, fc.c};
+    }
+    return true;
+}
+
+void write_bytes(std::vector<unsigned char>& out, const void* data, std::size_t size) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+} //static
+
+bool read_stage_json(const char* begin, const char* end, stage_data& out) {
+    int num_rows = 0;
+    int num_cols = 0;
+    std::vector<tilemap::tile> tiles;
+
+    out.time_limit = -1;
+    out.spawn = {0, 0};
+    out.elves.clear();
+    out.beers.clear();
+
+    try {
+        json_reader in (begin, end);
+        in.read_object([&](const std::string& key) {
+            if (key == "num_rows") {
+                num_rows = in.read_int();
+            } else if (key == "num_cols") {
+                num_cols = in.read_int();
+            } else if (key == "tiles") {
+                if (num_rows > 0 && num_cols > 0) {
+                    tiles.reserve(std::size_t(num_rows) * num_cols);
+                }
+                in.read_array([&]{
+                    tilemap::tile t = {};
+                    int i = 0;
+                    in.read_array([&]{
+                        auto v = std::uint8_t(in.read_int());
+                        if (i == 0) t.flags = v;
+                        else if (i == 1) t.background = v;
+                        else if (i == 2) t.foreground = v;
+                        ++i;
+                    });
+                    tiles.push_back(t);
+                });
+            } else if (key == "time_limit") {
+                if (!in.read_null()) {
+                    out.time_limit = in.read_int();
+                }
+            } else if (key == "spawn") {
+                if (!in.read_null()) {
+                    in.read_object([&](const std::string& coord) {
+                        if (coord == "r") {
+                            out.spawn.r = in.read_int();
+                        } else if (coord == "c") {
+                            out.spawn.c = in.read_int();
+                        } else {
+                            in.skip();
+                        }
+                    });
+                }
+            } else if (key == "elves") {
+                read_cells(in, out.elves);
+            } else if (key == "beers") {
+                read_cells(in, out.beers);
+            } else {
+                in.skip();
+            }
+        });
+        in.finish();
+    } catch (const json_reader_error& e) {
+        std::clog << "read_stage_json: Warning: " << e.what() << std::endl;
+        return false;
+    }
+
+    if (num_rows <= 0 || num_cols <= 0 || tiles.size() != std::size_t(num_rows) * num_cols) {
+        std::clog << "read_stage_json: Warning: Expected " << num_rows << "x" << num_cols << " tiles, got " << tiles.size() << "." << std::endl;
+        return false;
+    }
+
+    out.map = tilemap::tilemap(num_rows, num_cols, std::move(tiles));
+
+    return true;
+}
+
+nlohmann::json stage_to_json(const stage_data& stage) {
+    nlohmann::json json;
+    json["num_rows"] = stage.map.get_num_rows();
+    json["num_cols"] = stage.map.get_num_cols();
+
+    for (int r = 0; r < stage.map.get_num_rows(); ++r) {
+        for (int c = 0; c < stage.map.get_num_cols(); ++c) {
+            auto& t = stage.map.get(r, c);
+            json["tiles"].push_back({t.flags, t.background, t.foreground});
+        }
+    }
+
+    for (auto& elf : stage.elves) {
+        json["elves"].push_back({elf.r, elf.c});
+    }
+
+    for (auto& beer : stage.beers) {
+        json["beers"].push_back({beer.r, beer.c});
+    }
+
+    json["spawn"]["r"] = stage.spawn.r;
+    json["spawn"]["c"] = stage.spawn.c;
+
+    if (stage.time_limit >= 0) {
+        json["time_limit"] = stage.time_limit;
+    }
+
+    return json;
+}
+
+bool read_stage_binary(const unsigned char* data, std::size_t size, stage_data& out) {
+    file_header header;
+    if (size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.num_rows <= 0 || header.num_cols <= 0) {
+        return false;
+    }
+
+    auto ptr = data + sizeof(header);
+    auto end = data + size;
+
+    if (!read_cells(ptr, end, header.num_elves, out.elves) || !read_cells(ptr, end, header.num_beers, out.beers)) {
+        return false;
+    }
+
+    auto num_tiles = std::size_t(header.num_rows) * std::size_t(header.num_cols);
+    if (std::size_t(end - ptr) / sizeof(tilemap::tile) < num_tiles) {
+        return false;
+    }
+
+    out.map = tilemap::tilemap(header.num_rows, header.num_cols, reinterpret_cast<const tilemap::tile*>(ptr));
+    out.time_limit = header.time_limit;
+    out.spawn = {header.spawn_r, header.spawn_c};
+
+    return true;
+}
+
+std::vector<unsigned char> write_stage_binary(const stage_data& stage) {
+    file_header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.num_rows = stage.map.get_num_rows();
+    header.num_cols = stage.map.get_num_cols();
+    header.time_limit = stage.time_limit;
+    header.spawn_r = stage.spawn.r;
+    header.spawn_c = stage.spawn.c;
+    header.num_elves = stage.elves.size();
+    header.num_beers = stage.beers.size();
+
+    std::vector<unsigned char> out;
+    write_bytes(out, &header, sizeof(header));
+
+    for (auto& cells : {&stage.elves, &stage.beers}) {
+        for (auto& cell : *cells) {
+            file_cell fc = {cell.r, cell.c};
+            write_bytes(out, &fc, sizeof(fc));
+        }
+    }
+
+    write_bytes(out, stage.map.data(), std::size_t(header.num_rows) * header.num_cols * sizeof(tilemap::tile));
+
+    return out;
+}
+
+bool load_stage(const std::string& name, stage_data& out) {
+    auto binary = assets::load("stages/"+name+".stage");
+    if (!binary) {
+        return false;
+    }
+
+    if (!read_stage_binary(binary.data(), binary.size(), out)) {
+        std::clog << "load_stage: Warning: \"" << name << ".stage\" is not a valid stage." << std::endl;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,43 @@
+#ifndef LD40_STAGE_HPP
+#define LD40_STAGE_HPP
+
+#include "tilemap.hpp"
+
+#include "json.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Everything a stage file holds. Positions are in tiles.
+struct stage_data {
+    struct cell {
+        int r;
+        int c;
+    };
+
+    tilemap::tilemap map = {1, 1};
+    int time_limit = -1; // In seconds, -1 if the stage doesn't set one
+    cell spawn = {0, 0};
+    std::vector<cell> elves;
+    std::vector<cell> beers;
+};
+
+// The JSON format is only for LD40_stageconv, to read or hand-edit stages. The game and editor use the binary format.
+
+// Streams the JSON format straight into the stage, without building a nlohmann::json tree.
+// Returns false if the JSON is malformed or the tile count doesn't match the size.
+bool read_stage_json(const char* begin, const char* end, stage_data& out);
+
+nlohmann::json stage_to_json(const stage_data& stage);
+
+// Binary format: header, elf and beer positions, then the tiles, row-major, in tilemap::tile's 3-byte layout.
+// Returns false if the data isn't a stage of this version.
+bool read_stage_binary(const unsigned char* data, std::size_t size, stage_data& out);
+
+std::vector<unsigned char> write_stage_binary(const stage_data& stage);
+
+// Loads stages/<name>.stage. Returns false if it's missing or invalid.
+bool load_stage(const std::string& name, stage_data& out);
+
+#endif //LD40_STAGE_HPP
@@ -1,34 +1,110 @@
 #include "text.hpp"
 
-void draw_string(msdf_font& font, const std::string& str, const glm::mat4& viewproj, const glm::vec2& pos, float scale, text_align align) {
-    auto model_mat = glm::mat4(1.f);
-    model_mat = glm::translate(model_mat, glm::vec3{pos, 0.f});
-    model_mat = glm::scale(model_mat, glm::vec3{scale, scale, 1.f});
+#include <cstddef>
+
+namespace {
+
+void add_glyph_quad(std::vector<msdf_font::vertex>& vertices, const msdf_font::glyph& glyph, float pen, float scale) {
+    auto r = glyph.rect * scale;
+    auto& uv = glyph.uv;
+    vertices.insert(vertices.end(), {
+        {{pen + r.x, r.y}, {uv.x, uv.y}},
+        {{pen + r.x, r.w}, {uv.x, uv.w}},
+        {{pen + r.z, r.w}, {uv.z, uv.w}},
+        {{pen + r.z, r.w}, {uv.z, uv.w}},
+        {{pen + r.z, r.y}, {uv.z, uv.y}},
+        {{pen + r.x, r.y}, {uv.x, uv.y}},
+    });
+}
+
+} //static
+
+text_mesh::text_mesh(msdf_font& font, const std::string& str, float scale, text_align align) {
+    // Quads are bucketed by atlas page so each page is one contiguous range.
+    std::vector<std::vector<msdf_font::vertex>> page_vertices;
+
+    auto& run = font.get_run(str);
+    auto origin = align == text_align::RIGHT ? -run.advance * scale : 0.f;
+
+    for (auto& placed : run.glyphs) {
+        auto& glyph = *placed.g;
+        if (glyph.page < 0) continue;
+        if (glyph.page >= int(page_vertices.size())) {
+            page_vertices.resize(glyph.page + 1);
+        }
+        add_glyph_quad(page_vertices[glyph.page], glyph, origin + placed.x * scale, scale);
+    }
+
+    std::vector<msdf_font::vertex> vertices;
+
+    for (auto page = 0; page < int(page_vertices.size()); ++page) {
+        auto& pv = page_vertices[page];
+        if (!pv.empty()) {
+            ranges.push_back({page, int(vertices.size()), int(pv.size())});
+            vertices.insert(vertices.end(), pv.begin(), pv.end());
+        }
+    }
+
+    if (vertices.empty()) return;
+
+    vao = sushi::make_unique_vertex_array();
+    vertex_buffer = sushi::make_unique_buffer();
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer.get());
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(msdf_font::vertex), &vertices[0], GL_STATIC_DRAW);
+
+    sushi::bind_vertex_array(vao.get());
+    glEnableVertexAttribArray(sushi::attrib_location::POSITION);
+    glEnableVertexAttribArray(sushi::attrib_location::TEXCOORD);
+    glVertexAttribPointer(
+        sushi::attrib_location::POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(msdf_font::vertex),
+        reinterpret_cast<const GLvoid*>(offsetof(msdf_font::vertex, position)));
+    glVertexAttribPointer(
+        sushi::attrib_location::TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(msdf_font::vertex),
+        reinterpret_cast<const GLvoid*>(offsetof(msdf_font::vertex, texcoord)));
+}
+
+void text_mesh::draw(const msdf_font& font, const glm::mat4& mvp) const {
+    if (ranges.empty()) return;
 
     font.bind_shader();
+    sushi::set_uniform("MVP", mvp);
+    sushi::bind_vertex_array(vao.get());
+
+    for (const auto& r : ranges) {
+        sushi::set_texture(0, font.get_page(r.page));
+        glDrawArrays(GL_TRIANGLES, r.first, r.count);
+    }
+}
+
+text_layout::text_layout(std::shared_ptr<msdf_font> font, const std::string& str, float scale, text_align align) {
+    set(std::move(font), str, scale, align);
+}
 
-    auto draw_glyph = [&](auto& glyph) {
-        sushi::set_uniform("MVP", viewproj*model_mat);
-        sushi::set_uniform("texSize", glm::vec2{glyph.texture.width,glyph.texture.height});
-        sushi::set_texture(0, glyph.texture);
-        sushi::draw_mesh(glyph.mesh);
-    };
-
-    switch (align) {
-        case text_align::LEFT:
-            for (auto c : str) {
-                auto& glyph = font.get_glyph(c);
-                draw_glyph(glyph);
-                model_mat = glm::translate(model_mat, glm::vec3{glyph.advance, 0.f, 0.f});
-            }
-            break;
-        case text_align::RIGHT:
-            for (auto c : utility::reversed(str)) {
-                auto& glyph = font.get_glyph(c);
-                model_mat = glm::translate(model_mat, glm::vec3{-glyph.advance, 0.f, 0.f});
-                draw_glyph(glyph);
-            }
-            break;
+bool text_layout::set(std::shared_ptr<msdf_font> f, const std::string& s, float sc, text_align al) {
+    if (font == f && str == s && scale == sc && align == al) {
+        return false;
     }
+
+    font = std::move(f);
+    str = s;
+    scale = sc;
+    align = al;
+    mesh = text_mesh(*font, str, scale, align);
+
+    return true;
+}
+
+void text_layout::draw(const glm::mat4& viewproj, const glm::vec2& pos) const {
+    if (!font) return;
+
+    mesh.draw(*font, glm::translate(viewproj, glm::vec3{pos, 0.f}));
 }
 
+const std::string& text_layout::get_string() const {
+    return str;
+}
+
+void draw_string(msdf_font& font, const std::string& str, const glm::mat4& viewproj, const glm::vec2& pos, float scale, text_align align) {
+    text_mesh(font, str, scale, align).draw(font, glm::translate(viewproj, glm::vec3{pos, 0.f}));
+}
@@ -4,12 +4,61 @@
 #include "font.hpp"
 #include "utility.hpp"
 
+#include <sushi/mesh.hpp>
+
+#include <vector>
+
 enum class text_align {
     LEFT,
     RIGHT
 };
 
+// A string laid out in one vertex buffer, relative to the pen's starting point, with ems scaled by `scale`.
+// Drawn with one call per font atlas page, which is usually one call.
+class text_mesh {
+public:
+    text_mesh() = default;
+
+    text_mesh(msdf_font& font, const std::string& str, float scale, text_align align);
+
+    void draw(const msdf_font& font, const glm::mat4& mvp) const;
+
+private:
+    struct range {
+        int page;
+        int first;
+        int count;
+    };
+
+    std::vector<range> ranges;
+    sushi::unique_vertex_array vao;
+    sushi::unique_buffer vertex_buffer;
+};
+
+// Keeps a string's text_mesh between frames.
+// The mesh is only rebuilt when the font, string, scale or alignment changes.
+class text_layout {
+public:
+    text_layout() = default;
+
+    text_layout(std::shared_ptr<msdf_font> font, const std::string& str, float scale, text_align align);
+
+    // Returns true if the layout had to be rebuilt.
+    bool set(std::shared_ptr<msdf_font> font, const std::string& str, float scale, text_align align);
+
+    void draw(const glm::mat4& viewproj, const glm::vec2& pos) const;
+
+    const std::string& get_string() const;
+
+private:
+    std::shared_ptr<msdf_font> font;
+    std::string str;
+    float scale = 0;
+    text_align align = text_align::LEFT;
+    text_mesh mesh;
+};
+
+// Lays out and draws the string from scratch. Prefer a text_layout for anything drawn every frame.
 void draw_string(msdf_font& font, const std::string& str, const glm::mat4& viewproj, const glm::vec2& pos, float scale, text_align align);
 
 #endif //LD40_TEXT_HPP
-
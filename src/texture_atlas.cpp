@@ -0,0 +1,130 @@
+#include "texture_atlas.hpp"
+
+#include "assets.hpp"
+
+#include <lodepng.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+struct image {
+    std::string name;
+    std::vector<unsigned char> pixels;
+    int width;
+    int height;
+};
+
+// Copies the image into the page at (x,y), extruding its edge texels outward by `padding`.
+void blit(std::vector<unsigned char>& page, int page_size, const image& img, int x, int y, int padding) {
+    for (auto py = -padding; py < img.height + padding; ++py) {
+        auto sy = std::min(std::max(py, 0), img.height - 1);
+        for (auto px = -padding; px < img.width + padding; ++px) {
+            auto sx = std::min(std::max(px, 0), img.width - 1);
+            auto src = &img.pixels[(sy * img.width + sx) * 4];
+            auto dst = &page[((y + py) * page_size + (x + px)) * 4];
+            std::copy(src, src + 4, dst);
+        }
+    }
+}
+
+} //static
+
+texture_region whole_texture(std::shared_ptr<sushi::texture_2d> texture) {
+    texture_region rv;
+    rv.width = texture->width;
+    rv.height = texture->height;
+    rv.texture = std::move(texture);
+    return rv;
+}
+
+texture_atlas::texture_atlas(const nlohmann::json& manifest) {
+    page_size = manifest["page_size"];
+    int padding = manifest["padding"];
+
+    std::vector<image> images;
+
+    for (auto& namejson : manifest["textures"]) {
+        image img;
+        img.name = namejson.get<std::string>();
+
+        auto png = assets::load("textures/"+img.name+".png");
+        unsigned w, h;
+        if (!png || lodepng::decode(img.pixels, w, h, png.data(), png.size()) != 0) {
+            std::clog << "texture_atlas: Warning: Unable to load texture \"" << img.name << "\"." << std::endl;
+            continue;
+        }
+
+        img.width = w;
+        img.height = h;
+
+        if (img.width + padding * 2 > page_size || img.height + padding * 2 > page_size) {
+            std::clog << "texture_atlas: Warning: Texture \"" << img.name << "\" is too large for the atlas." << std::endl;
+            continue;
+        }
+
+        images.push_back(std::move(img));
+    }
+
+    // Tallest first packs the skyline most tightly.
+    std::sort(begin(images), end(images), [](const image& a, const image& b) {
+        return std::make_pair(a.height, a.width) > std::make_pair(b.height, b.width);
+    });
+
+    std::vector<skyline_packer> packers;
+
+    for (auto& img : images) {
+        auto w = img.width + padding * 2;
+        auto h = img.height + padding * 2;
+        int x, y;
+
+        auto page = 0;
+        while (page < int(packers.size()) && !packers[page].pack(w, h, x, y)) {
+            ++page;
+        }
+
+        if (page == int(packers.size())) {
+            packers.emplace_back(page_size, page_size);
+            page_pixels.emplace_back(page_size * page_size * 4, 0);
+            packers.back().pack(w, h, x, y);
+        }
+
+        blit(page_pixels[page], page_size, img, x + padding, y + padding, padding);
+
+        auto& region = regions[img.name];
+        region.x = x + padding;
+        region.y = y + padding;
+        region.width = img.width;
+        region.height = img.height;
+        region_pages.emplace_back(img.name, page);
+    }
+
+    std::clog << "texture_atlas: Packed " << images.size() << " textures into " << page_pixels.size() << " pages." << std::endl;
+}
+
+void texture_atlas::upload() {
+    for (auto& pixels : page_pixels) {
+        pages.push_back(std::make_shared<sushi::texture_2d>(
+            sushi::create_texture_2d(&pixels[0], page_size, page_size, false, false, false, false)));
+    }
+
+    for (auto& rp : region_pages) {
+        regions[rp.first].texture = pages[rp.second];
+    }
+
+    page_pixels.clear();
+    region_pages.clear();
+}
+
+const texture_region* texture_atlas::find(const std::string& name) const {
+    auto iter = regions.find(name);
+    if (iter == end(regions)) {
+        return nullptr;
+    }
+    return &iter->second;
+}
+
+const std::vector<std::shared_ptr<sushi::texture_2d>>& texture_atlas::get_pages() const {
+    return pages;
+}
@@ -0,0 +1,54 @@
+#ifndef LD40_TEXTURE_ATLAS_HPP
+#define LD40_TEXTURE_ATLAS_HPP
+
+#include "skyline_packer.hpp"
+
+#include "json.hpp"
+
+#include <sushi/texture.hpp>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// A rectangle of texels within a texture, in pixels from the top-left corner.
+struct texture_region {
+    std::shared_ptr<sushi::texture_2d> texture;
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// Covers the whole texture.
+texture_region whole_texture(std::shared_ptr<sushi::texture_2d> texture);
+
+// Packs a set of images from data/textures into as few pages as possible.
+// Each image is surrounded by `padding` texels copied from its edges, so sampling never bleeds into a neighbor.
+class texture_atlas {
+public:
+    texture_atlas() = default;
+
+    // Decodes and packs the images listed in the manifest: {"page_size": N, "padding": N, "textures": [names...]}.
+    // Doesn't touch OpenGL, so it can run on a worker. The regions have no texture until upload() runs.
+    texture_atlas(const nlohmann::json& manifest);
+
+    // Creates the page textures from the packed pixels, which are then released. Call on the main thread.
+    void upload();
+
+    // Returns nullptr if the image isn't in the atlas.
+    const texture_region* find(const std::string& name) const;
+
+    const std::vector<std::shared_ptr<sushi::texture_2d>>& get_pages() const;
+
+private:
+    int page_size = 0;
+    std::vector<std::vector<unsigned char>> page_pixels;
+    std::vector<std::pair<std::string, int>> region_pages;
+    std::vector<std::shared_ptr<sushi::texture_2d>> pages;
+    std::unordered_map<std::string, texture_region> regions;
+};
+
+#endif //LD40_TEXTURE_ATLAS_HPP
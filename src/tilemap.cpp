@@ -1,30 +1,46 @@
 #include "tilemap.hpp"
 
+#include <atomic>
+#include <cstring>
+#include <utility>
+
 namespace tilemap {
 
+namespace {
+
+// Stages are loaded on workers too, so tilemaps can be built on several threads at once.
+int next_revision() {
+    static std::atomic<int> revision {0};
+    return ++revision;
+}
+
+} //static
+
 tilemap::tilemap(int rows, int cols) :
     tiles(rows*cols),
     num_rows(rows),
     num_cols(cols)
-{}
-
-tilemap::tilemap(const nlohmann::json& json) :
-    tiles(),
-    num_rows(),
-    num_cols()
 {
-    num_rows = json["num_rows"];
-    num_cols = json["num_cols"];
-
-    tiles.reserve(num_rows * num_cols);
+    reset_chunks();
+}
 
-    for (auto&& tilejson : json["tiles"]) {
-        tile t;
-        t.flags = tilejson[0];
-        t.background = tilejson[1];
-        t.foreground = tilejson[2];
-        tiles.emplace_back(t);
+tilemap::tilemap(int rows, int cols, const tile* data) :
+    tiles(rows*cols),
+    num_rows(rows),
+    num_cols(cols)
+{
+    if (!tiles.empty()) {
+        std::memcpy(tiles.data(), data, tiles.size() * sizeof(tile));
     }
+    reset_chunks();
+}
+
+tilemap::tilemap(int rows, int cols, std::vector<tile> data) :
+    tiles(std::move(data)),
+    num_rows(rows),
+    num_cols(cols)
+{
+    reset_chunks();
 }
 
 int tilemap::get_num_rows() const {
@@ -44,6 +60,7 @@ void tilemap::set_num_rows(int newr) {
     }
     tiles = std::move(newtiles);
     num_rows = newr;
+    reset_chunks();
 }
 
 void tilemap::set_num_cols(int newc) {
@@ -55,6 +72,7 @@ void tilemap::set_num_cols(int newc) {
     }
     tiles = std::move(newtiles);
     num_cols = newc;
+    reset_chunks();
 }
 
 const tile& tilemap::get(int r, int c) const {
@@ -62,8 +80,29 @@ const tile& tilemap::get(int r, int c) const {
 }
 
 tile& tilemap::get(int r, int c) {
+    chunk_revisions[(r / CHUNK_SIZE) * get_num_chunk_cols() + c / CHUNK_SIZE] = next_revision();
     const auto& self = *this;
     return const_cast<tile&>(self.get(r, c));
 }
 
+const tile* tilemap::data() const {
+    return tiles.data();
+}
+
+int tilemap::get_num_chunk_rows() const {
+    return (num_rows + CHUNK_SIZE - 1) / CHUNK_SIZE;
+}
+
+int tilemap::get_num_chunk_cols() const {
+    return (num_cols + CHUNK_SIZE - 1) / CHUNK_SIZE;
+}
+
+int tilemap::get_chunk_revision(int cr, int cc) const {
+    return chunk_revisions[cr * get_num_chunk_cols() + cc];
+}
+
+void tilemap::reset_chunks() {
+    chunk_revisions.assign(get_num_chunk_rows() * get_num_chunk_cols(), next_revision());
+}
+
 } //namespace tilemap
@@ -1,8 +1,6 @@
 #ifndef LD40_TILEMAP_HPP
 #define LD40_TILEMAP_HPP
 
-#include "json.hpp"
-
 #include <cstdint>
 #include <vector>
 
@@ -21,13 +19,23 @@ struct tile {
     std::uint8_t foreground;
 };
 
+// Binary stages store tiles in exactly this layout.
+static_assert(sizeof(tile) == 3, "tile must be 3 bytes");
+
+// Tiles are grouped into square chunks for change tracking and rendering.
+constexpr int CHUNK_SIZE = 16;
+
 class tilemap {
 public:
     tilemap() = default;
 
     tilemap(int rows, int cols);
 
-    tilemap(const nlohmann::json& json);
+    // Copies rows*cols tiles, row-major.
+    tilemap(int rows, int cols, const tile* data);
+
+    // Takes rows*cols tiles, row-major.
+    tilemap(int rows, int cols, std::vector<tile> data);
 
     int get_num_rows() const;
 
@@ -39,10 +47,24 @@ public:
 
     const tile& get(int r, int c) const;
 
+    // Marks the tile's chunk as changed, since the caller may write through the reference.
     tile& get(int r, int c);
 
+    // All tiles, row-major.
+    const tile* data() const;
+
+    int get_num_chunk_rows() const;
+
+    int get_num_chunk_cols() const;
+
+    // Changes whenever a tile in the chunk may have changed. Revisions are unique across all tilemaps.
+    int get_chunk_revision(int cr, int cc) const;
+
 private:
+    void reset_chunks();
+
     std::vector<tile> tiles;
+    std::vector<int> chunk_revisions;
     int num_rows = 0;
     int num_cols = 0;
 };
@@ -0,0 +1,106 @@
+#include "tilemap_mesh.hpp"
+
+#include <sushi/texture.hpp>
+
+#include <algorithm>
+
+namespace tilemap {
+
+tilemap_mesh::tilemap_mesh(std::shared_ptr<spritesheet> sheet) :
+    sheet(std::move(sheet)),
+    chunks(),
+    num_chunk_rows(0),
+    num_chunk_cols(0)
+{}
+
+void tilemap_mesh::update(const tilemap& map) {
+    if (map.get_num_chunk_rows() != num_chunk_rows || map.get_num_chunk_cols() != num_chunk_cols) {
+        num_chunk_rows = map.get_num_chunk_rows();
+        num_chunk_cols = map.get_num_chunk_cols();
+        chunks.clear();
+        chunks.resize(num_chunk_rows * num_chunk_cols);
+    }
+
+    for (auto cr = 0; cr < num_chunk_rows; ++cr) {
+        for (auto cc = 0; cc < num_chunk_cols; ++cc) {
+            if (chunks[cr * num_chunk_cols + cc].revision != map.get_chunk_revision(cr, cc)) {
+                build_chunk(map, cr, cc);
+            }
+        }
+    }
+}
+
+void tilemap_mesh::draw(layer l) const {
+    draw(l, 0, num_chunk_rows * CHUNK_SIZE, 0, num_chunk_cols * CHUNK_SIZE);
+}
+
+void tilemap_mesh::draw(layer l, int first_row, int last_row, int first_col, int last_col) const {
+    if (first_row >= last_row || first_col >= last_col) return;
+
+    auto first_cr = std::max(first_row / CHUNK_SIZE, 0);
+    auto last_cr = std::min((last_row - 1) / CHUNK_SIZE + 1, num_chunk_rows);
+    auto first_cc = std::max(first_col / CHUNK_SIZE, 0);
+    auto last_cc = std::min((last_col - 1) / CHUNK_SIZE + 1, num_chunk_cols);
+
+    sushi::set_texture(0, sheet->get_texture());
+
+    for (auto cr = first_cr; cr < last_cr; ++cr) {
+        for (auto cc = first_cc; cc < last_cc; ++cc) {
+            auto& mesh = chunks[cr * num_chunk_cols + cc].meshes[l];
+            if (mesh.num_triangles > 0) {
+                sushi::draw_mesh(mesh);
+            }
+        }
+    }
+}
+
+void tilemap_mesh::build_chunk(const tilemap& map, int cr, int cc) {
+    auto& chunk = chunks[cr * num_chunk_cols + cc];
+
+    auto last_row = std::min((cr + 1) * CHUNK_SIZE, map.get_num_rows());
+    auto last_col = std::min((cc + 1) * CHUNK_SIZE, map.get_num_cols());
+
+    for (auto l = 0; l < NUM_LAYERS; ++l) {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> texcoords;
+        std::vector<sushi::Tri> tris;
+
+        for (auto r = cr * CHUNK_SIZE; r < last_row; ++r) {
+            for (auto c = cc * CHUNK_SIZE; c < last_col; ++c) {
+                auto& tile = map.get(r, c);
+
+                int cell;
+                if (l == BACKGROUND_LAYER && tile.flags & BACKGROUND) {
+                    cell = tile.background;
+                } else if (l == FOREGROUND_LAYER && tile.flags & FOREGROUND) {
+                    cell = tile.foreground;
+                } else {
+                    continue;
+                }
+
+                auto uv = sheet->get_uv_rect(cell/16, cell%16);
+                auto left = float(c * 16);
+                auto right = left + 16;
+                auto bottom = float(r * 16);
+                auto top = bottom + 16;
+                auto z = float(l);
+
+                auto base = sushi::Tri::Index3(positions.size());
+                positions.insert(positions.end(), {{left, bottom, z},{left, top, z},{right, top, z},{right, bottom, z}});
+                texcoords.insert(texcoords.end(), {{uv.x, uv.w},{uv.x, uv.y},{uv.z, uv.y},{uv.z, uv.w}});
+                tris.push_back({{{base+0,0,base+0},{base+1,0,base+1},{base+2,0,base+2}}});
+                tris.push_back({{{base+2,0,base+2},{base+3,0,base+3},{base+0,0,base+0}}});
+            }
+        }
+
+        if (tris.empty()) {
+            chunk.meshes[l] = {};
+        } else {
+            chunk.meshes[l] = sushi::load_static_mesh_data(positions, {{0.f, 0.f, 1.f}}, texcoords, tris);
+        }
+    }
+
+    chunk.revision = map.get_chunk_revision(cr, cc);
+}
+
+} //namespace tilemap
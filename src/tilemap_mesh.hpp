@@ -0,0 +1,53 @@
+#ifndef LD40_TILEMAP_MESH_HPP
+#define LD40_TILEMAP_MESH_HPP
+
+#include "tilemap.hpp"
+#include "spritesheet.hpp"
+
+#include <sushi/mesh.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace tilemap {
+
+// Static meshes for a tilemap, baked per chunk and layer.
+// Vertices are in world space, one tile per 16 units, with the foreground layer raised to z = 1.
+class tilemap_mesh {
+public:
+    enum layer {
+        BACKGROUND_LAYER,
+        FOREGROUND_LAYER,
+        NUM_LAYERS
+    };
+
+    tilemap_mesh() = default;
+
+    tilemap_mesh(std::shared_ptr<spritesheet> sheet);
+
+    // Rebuilds the chunks that changed since the last update.
+    void update(const tilemap& map);
+
+    // Draws all chunks of a layer.
+    void draw(layer l) const;
+
+    // Draws the chunks of a layer that overlap the tile range [first_row,last_row) x [first_col,last_col).
+    void draw(layer l, int first_row, int last_row, int first_col, int last_col) const;
+
+private:
+    struct chunk {
+        int revision = 0;
+        sushi::static_mesh meshes[NUM_LAYERS];
+    };
+
+    void build_chunk(const tilemap& map, int cr, int cc);
+
+    std::shared_ptr<spritesheet> sheet;
+    std::vector<chunk> chunks;
+    int num_chunk_rows = 0;
+    int num_chunk_cols = 0;
+};
+
+} //namespace tilemap
+
+#endif //LD40_TILEMAP_MESH_HPP
@@ -0,0 +1,190 @@
+#include "timeline.hpp"
+
+#include "json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace timeline {
+
+namespace {
+
+struct event {
+    std::string name;
+    int thread;
+    clock::time_point start;
+    clock::time_point end;
+    bool instant;
+};
+
+// Set during static initialization, so it's as close to process start as this code can get.
+const clock::time_point origin = clock::now();
+
+struct event_log {
+    std::mutex mutex;
+    std::vector<event> events;
+};
+
+event_log& get_log() {
+    static event_log log;
+    return log;
+}
+
+// Small, stable ids read better in trace viewers than hashed std::thread::ids.
+int thread_index() {
+    static std::atomic<int> next_index {0};
+    thread_local int index = next_index++;
+    return index;
+}
+
+void add(std::string name, clock::time_point start, clock::time_point end, bool instant) {
+    auto& log = get_log();
+    auto thread = thread_index();
+    std::lock_guard<std::mutex> lock (log.mutex);
+    log.events.push_back({std::move(name), thread, start, end, instant});
+}
+
+double to_ms(clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+} //static
+
+scope::scope(std::string name) : name(std::move(name)), start(clock::now()) {}
+
+scope::~scope() {
+    add(std::move(name), start, clock::now(), false);
+}
+
+phases::phases(std::string name) : name(std::move(name)), start(clock::now()), phase_start(start) {}
+
+phases::~phases() {
+    end();
+}
+
+void phases::next(std::string p) {
+    auto now = clock::now();
+    if (!phase.empty()) {
+        add(std::move(phase), phase_start, now, false);
+    }
+    phase = std::move(p);
+    phase_start = now;
+}
+
+void phases::end() {
+    if (ended) {
+        return;
+    }
+    ended = true;
+    auto now = clock::now();
+    if (!phase.empty()) {
+        add(std::move(phase), phase_start, now, false);
+    }
+    add(std::move(name), start, now, false);
+}
+
+void record(const std::string& name, clock::time_point start, clock::time_point end) {
+    add(name, start, end, false);
+}
+
+void mark(const std::string& name) {
+    auto now = clock::now();
+    add(name, now, now, true);
+}
+
+double seconds_since_start() {
+    return std::chrono::duration<double>(clock::now() - origin).count();
+}
+
+void print_summary(std::ostream& out) {
+    struct row {
+        std::string name;
+        int count = 0;
+        clock::duration total = {};
+        clock::duration longest = {};
+    };
+
+    std::vector<row> rows;
+    std::vector<std::pair<std::string, clock::time_point>> marks;
+
+    {
+        auto& log = get_log();
+        std::lock_guard<std::mutex> lock (log.mutex);
+        std::unordered_map<std::string, std::size_t> index;
+        for (auto& e : log.events) {
+            if (e.instant) {
+                marks.emplace_back(e.name, e.start);
+                continue;
+            }
+            auto iter = index.find(e.name);
+            if (iter == index.end()) {
+                iter = index.emplace(e.name, rows.size()).first;
+                rows.push_back({e.name});
+            }
+            auto& r = rows[iter->second];
+            auto d = e.end - e.start;
+            ++r.count;
+            r.total += d;
+            r.longest = std::max(r.longest, d);
+        }
+    }
+
+    std::stable_sort(begin(rows), end(rows), [](const row& a, const row& b) {
+        return a.total > b.total;
+    });
+
+    out << "Timeline:" << std::endl;
+    out << "    " << std::left << std::setw(40) << "span" << std::right
+        << std::setw(8) << "count" << std::setw(12) << "total ms" << std::setw(12) << "max ms" << std::endl;
+    auto flags = out.flags();
+    auto precision = out.precision(2);
+    out << std::fixed;
+    for (auto& r : rows) {
+        out << "    " << std::left << std::setw(40) << r.name << std::right
+            << std::setw(8) << r.count << std::setw(12) << to_ms(r.total) << std::setw(12) << to_ms(r.longest) << std::endl;
+    }
+    for (auto& m : marks) {
+        out << "    " << m.first << " at " << to_ms(m.second - origin) << " ms" << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool write_chrome_trace(const std::string& filename) {
+    auto trace = nlohmann::json::array();
+
+    {
+        auto& log = get_log();
+        std::lock_guard<std::mutex> lock (log.mutex);
+        for (auto& e : log.events) {
+            auto us = [&](clock::duration d) {
+                return std::chrono::duration<double, std::micro>(d).count();
+            };
+            nlohmann::json j;
+            j["name"] = e.name;
+            j["pid"] = 1;
+            j["tid"] = e.thread;
+            j["ts"] = us(e.start - origin);
+            if (e.instant) {
+                j["ph"] = "i";
+                j["s"] = "g";
+            } else {
+                j["ph"] = "X";
+                j["dur"] = us(e.end - e.start);
+            }
+            trace.push_back(std::move(j));
+        }
+    }
+
+    std::ofstream file (filename);
+    file << nlohmann::json{{"traceEvents", std::move(trace)}, {"displayTimeUnit", "ms"}};
+    return bool(file);
+}
+
+} //namespace timeline
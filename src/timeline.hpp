@@ -0,0 +1,65 @@
+#ifndef LD40_TIMELINE_HPP
+#define LD40_TIMELINE_HPP
+
+#include <chrono>
+#include <ostream>
+#include <string>
+
+// Records a timeline of named spans, such as startup phases and resource loads, from any thread.
+// The timeline can be printed as a summary table or saved as a Chrome trace (chrome://tracing, Perfetto).
+namespace timeline {
+
+using clock = std::chrono::steady_clock;
+
+// Records the time from construction to destruction as one span.
+class scope {
+public:
+    explicit scope(std::string name);
+    ~scope();
+
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+
+private:
+    std::string name;
+    clock::time_point start;
+};
+
+// Records a run of consecutive phases inside one enclosing span. Each phase ends when the next begins.
+class phases {
+public:
+    explicit phases(std::string name);
+    ~phases();
+
+    phases(const phases&) = delete;
+    phases& operator=(const phases&) = delete;
+
+    void next(std::string phase);
+
+    // Ends the current phase and the enclosing span. Called by the destructor if needed.
+    void end();
+
+private:
+    std::string name;
+    std::string phase;
+    clock::time_point start;
+    clock::time_point phase_start;
+    bool ended = false;
+};
+
+void record(const std::string& name, clock::time_point start, clock::time_point end);
+
+// Records an instant, such as the first frame.
+void mark(const std::string& name);
+
+// Time since the timeline started, which is when the program first touches it.
+double seconds_since_start();
+
+// Total, count and longest span for each name, longest total first.
+void print_summary(std::ostream& out);
+
+bool write_chrome_trace(const std::string& filename);
+
+} //namespace timeline
+
+#endif //LD40_TIMELINE_HPP
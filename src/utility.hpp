@@ -1,7 +1,9 @@
 #ifndef LD40_UTILITY_HPP
 #define LD40_UTILITY_HPP
 
+#include <string>
 #include <utility>
+#include <vector>
 
 #define EMBER_CAT_IMPL(A,B) A##B
 #define EMBER_CAT(A,B) EMBER_CAT_IMPL(A,B)
@@ -89,6 +91,43 @@ auto vectorify(Ts&&... ts) {
     return rv;
 }
 
+// Decodes UTF-8 into code points, replacing the contents of `out`. Malformed sequences become U+FFFD.
+inline void decode_utf8(const std::string& str, std::vector<int>& out) {
+    out.clear();
+
+    auto i = std::size_t(0);
+    auto n = str.size();
+
+    while (i < n) {
+        auto lead = static_cast<unsigned char>(str[i++]);
+        int len;
+        int cp;
+
+        if (lead < 0x80) { out.push_back(lead); continue; }
+        else if ((lead & 0xE0) == 0xC0) { len = 1; cp = lead & 0x1F; }
+        else if ((lead & 0xF0) == 0xE0) { len = 2; cp = lead & 0x0F; }
+        else if ((lead & 0xF8) == 0xF0) { len = 3; cp = lead & 0x07; }
+        else { out.push_back(0xFFFD); continue; }
+
+        auto ok = true;
+        for (auto k = 0; k < len; ++k) {
+            if (i >= n || (static_cast<unsigned char>(str[i]) & 0xC0) != 0x80) {
+                ok = false;
+                break;
+            }
+            cp = (cp << 6) | (static_cast<unsigned char>(str[i++]) & 0x3F);
+        }
+
+        // Reject overlong encodings, surrogates and anything past U+10FFFF.
+        static const int min_cp[] = {0, 0x80, 0x800, 0x10000};
+        if (!ok || cp < min_cp[len] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            cp = 0xFFFD;
+        }
+
+        out.push_back(cp);
+    }
+}
+
 } //namespace utility
 
 #endif //LD40_UTILITY_HPP
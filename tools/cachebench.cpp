@@ -0,0 +1,554 @@
+// Measures the per-frame cost of resource lookups, and how resource_cache holds up under contention.
+// Usage: LD40_cachebench [--stress] [--contention] [--frames=<n>] [sprites...]
+// Each frame looks up the tile sheet once and every sprite's animation once, like gameplay_state's draw.
+// The default sprite counts are 100, 1000 and 10000, over a handful of names.
+//   std::map      the tuple-keyed std::map lookup resource_cache used to do.
+//   get(key)      resource_cache::get with the string key, which hashes and interns it.
+//   get(handle)   resource_cache::get with handles interned up front.
+//   resolver      a resource_cache::resolver made every frame, as the game does now, so each name is
+//                 looked up in the cache once per frame.
+// The last column is the share of a 60 Hz frame spent on lookups.
+// --contention instead times lookups of a few hot keys from 1 to 16 threads at once, against one mutex around a std::map.
+// Lower is better. Past the number of hardware threads, extra threads only show the cost of lock handoffs.
+// --stress only checks that many threads calling get, get_async, clear and reload on a few keys load each key once
+// per clear or reload, and always get the right resource, that budgeted caches only evict on the main thread,
+// and that default handles are rejected.
+// It exits with 1 if not.
+
+#include "resource_cache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const char* const SPRITE_NAMES[] = {"tipsy", "elf", "beer", "rightfist", "leftfist", "upfist", "downfist"};
+
+struct fake_resource {
+    std::string name;
+};
+
+struct sprite_ref {
+    std::string name;
+    resource_handle handle;
+};
+
+enum class mode {
+    MAP,
+    KEY,
+    HANDLE,
+    RESOLVER
+};
+
+// Defeats the optimizer without costing much.
+volatile std::size_t sink = 0;
+
+double run(mode m, int count, int frames) {
+    resource_cache<fake_resource, std::string> sprites ([](const std::string& name) { return fake_resource{name}; });
+    resource_cache<fake_resource, std::string, int, int> sheets ([](const std::string& name, int, int) { return fake_resource{name}; });
+
+    std::map<std::tuple<std::string>, std::shared_ptr<fake_resource>> sprite_map;
+    std::map<std::tuple<std::string, int, int>, std::shared_ptr<fake_resource>> sheet_map;
+
+    std::vector<sprite_ref> refs;
+    for (auto i = 0; i < count; ++i) {
+        std::string name = SPRITE_NAMES[i % (sizeof(SPRITE_NAMES) / sizeof(SPRITE_NAMES[0]))];
+        refs.push_back({name, sprites.intern(name)});
+        sprite_map[std::make_tuple(name)] = std::make_shared<fake_resource>(fake_resource{name});
+    }
+    auto tiles = sheets.intern("tiles", 16, 16);
+    sheet_map[std::make_tuple(std::string("tiles"), 16, 16)] = std::make_shared<fake_resource>(fake_resource{"tiles"});
+
+    // Warm the caches, so only lookups are timed.
+    for (auto& r : refs) {
+        sprites.get(r.handle);
+    }
+    sheets.get(tiles);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (auto f = 0; f < frames; ++f) {
+        switch (m) {
+            case mode::MAP:
+                sink += sheet_map[std::make_tuple(std::string("tiles"), 16, 16)]->name.size();
+                for (auto& r : refs) {
+                    sink += sprite_map[std::make_tuple(r.name)]->name.size();
+                }
+                break;
+            case mode::KEY:
+                sink += sheets.get("tiles", 16, 16)->name.size();
+                for (auto& r : refs) {
+                    sink += sprites.get(r.name)->name.size();
+                }
+                break;
+            case mode::HANDLE:
+                sink += sheets.get(tiles)->name.size();
+                for (auto& r : refs) {
+                    sink += sprites.get(r.handle)->name.size();
+                }
+                break;
+            case mode::RESOLVER: {
+                sink += sheets.get(tiles)->name.size();
+                resource_cache<fake_resource, std::string>::resolver resolved (sprites);
+                for (auto& r : refs) {
+                    sink += resolved.get(r.handle)->name.size();
+                }
+                break;
+            }
+        }
+    }
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Stress test
+
+constexpr int STRESS_THREADS = 16;
+constexpr int NUM_STRESS_KEYS = 5;
+
+const char* const STRESS_KEYS[NUM_STRESS_KEYS] = {"tiles", "elf", "beer", "tipsy", "editor"};
+
+int key_index(const std::string& name) {
+    return int(std::find(std::begin(STRESS_KEYS), std::end(STRESS_KEYS), name) - std::begin(STRESS_KEYS));
+}
+
+using call_counts = std::array<std::atomic<int>, NUM_STRESS_KEYS>;
+
+call_counts factory_calls;
+call_counts prepare_calls;
+call_counts finish_calls;
+
+// Slow enough that threads pile up on loads in flight.
+void pretend_to_load() {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+}
+
+// At namespace scope, like the game's caches, so they outlive the loader's workers and any tasks still queued.
+resource_cache<fake_resource, std::string> sync_cache ([](const std::string& name) {
+    ++factory_calls[key_index(name)];
+    pretend_to_load();
+    return fake_resource{name};
+});
+
+resource_cache<fake_resource, std::string> async_cache (async_factory, [](const std::string& name) {
+    ++prepare_calls[key_index(name)];
+    pretend_to_load();
+    return resource_cache<fake_resource, std::string>::finish_function([name]{
+        ++finish_calls[key_index(name)];
+        return std::make_shared<fake_resource>(fake_resource{name});
+    });
+});
+
+// Like a texture, it must only be destroyed on the main thread.
+struct main_thread_resource {
+    explicit main_thread_resource(std::string name) : name(std::move(name)) {}
+    ~main_thread_resource();
+
+    std::string name;
+};
+
+std::thread::id main_thread = std::this_thread::get_id();
+std::atomic<int> destroyed_off_main {0};
+
+main_thread_resource::~main_thread_resource() {
+    if (std::this_thread::get_id() != main_thread) {
+        ++destroyed_off_main;
+    }
+}
+
+// Each resource counts as one byte, so a small budget evicts constantly.
+resource_cache<main_thread_resource, std::string> budget_cache (async_factory, [](const std::string& name) {
+    return resource_cache<main_thread_resource, std::string>::finish_function([name]{
+        return std::make_shared<main_thread_resource>(name);
+    });
+}, [](const main_thread_resource&) { return std::size_t(1); });
+
+std::atomic<int> failures {0};
+
+void expect(bool ok, const std::string& what) {
+    if (!ok && failures++ < 10) {
+        std::cerr << "FAILED: " << what << std::endl;
+    }
+}
+
+template <typename T>
+void expect_resource(const std::shared_ptr<T>& ptr, const std::string& name) {
+    expect(ptr && ptr->name == name, "got the wrong resource for " + name);
+}
+
+// Lets the threads go at once, so their first requests overlap.
+class start_line {
+public:
+    explicit start_line(int count) : waiting(count) {}
+
+    void arrive() {
+        --waiting;
+        while (waiting > 0) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    std::atomic<int> waiting;
+};
+
+void reset_counts() {
+    for (auto i = 0; i < NUM_STRESS_KEYS; ++i) {
+        factory_calls[i] = 0;
+        prepare_calls[i] = 0;
+        finish_calls[i] = 0;
+    }
+}
+
+// Runs queued main-thread tasks until none are left. Thread 0 stands in for the main thread.
+void drain_main_queue() {
+    for (auto i = 0; i < 10; ++i) {
+        async_loader::update(std::chrono::seconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// Every thread asks for every key at once, each through a different call, so every key must load exactly once.
+void stress_single_flight(int rounds) {
+    for (auto round = 0; round < rounds; ++round) {
+        sync_cache.clear();
+        async_cache.clear();
+        drain_main_queue();
+        reset_counts();
+
+        std::array<std::array<fake_resource*, NUM_STRESS_KEYS>, STRESS_THREADS> seen = {};
+        start_line line (STRESS_THREADS);
+        std::vector<std::thread> threads;
+
+        for (auto t = 0; t < STRESS_THREADS; ++t) {
+            threads.emplace_back([&, t]{
+                line.arrive();
+                for (auto k = 0; k < NUM_STRESS_KEYS; ++k) {
+                    auto key = (k + t) % NUM_STRESS_KEYS;
+                    std::string name = STRESS_KEYS[key];
+                    std::shared_ptr<fake_resource> ptr;
+
+                    switch ((t + round) % 3) {
+                        case 0: ptr = sync_cache.get(name); break;
+                        case 1: ptr = sync_cache.get(sync_cache.intern(name)); break;
+                        case 2: ptr = sync_cache.get_async(name).get(); break;
+                    }
+                    expect_resource(ptr, name);
+
+                    auto async_ptr = t % 2 == 0 ? async_cache.get(name) : async_cache.get_async(name).get();
+                    expect_resource(async_ptr, name);
+
+                    seen[t][key] = ptr.get();
+                }
+            });
+        }
+
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        for (auto k = 0; k < NUM_STRESS_KEYS; ++k) {
+            std::string name = STRESS_KEYS[k];
+            expect(factory_calls[k] == 1, name + " was loaded " + std::to_string(factory_calls[k]) + " times");
+            expect(prepare_calls[k] == 1, name + " was prepared " + std::to_string(prepare_calls[k]) + " times");
+            expect(finish_calls[k] == 1, name + " was finished " + std::to_string(finish_calls[k]) + " times");
+            for (auto t = 1; t < STRESS_THREADS; ++t) {
+                expect(seen[t][k] == seen[0][k], "threads got different copies of " + name);
+            }
+        }
+    }
+}
+
+// Every thread mixes lookups with clear() and reload(). A key may load again after each clear() and each reload()
+// of it, but never more often than that, and every request still gets its own key.
+void stress_churn(int iterations) {
+    sync_cache.clear();
+    async_cache.clear();
+    drain_main_queue();
+    reset_counts();
+
+    std::atomic<int> clears {0};
+    std::array<std::atomic<int>, NUM_STRESS_KEYS> reloads = {};
+    start_line line (STRESS_THREADS);
+    std::vector<std::thread> threads;
+
+    for (auto t = 0; t < STRESS_THREADS; ++t) {
+        threads.emplace_back([&, t]{
+            std::minstd_rand rng (t + 1);
+            std::vector<std::pair<std::string, resource_cache<fake_resource, std::string>::future>> futures;
+
+            line.arrive();
+            for (auto i = 0; i < iterations; ++i) {
+                auto key = int(rng() % NUM_STRESS_KEYS);
+                std::string name = STRESS_KEYS[key];
+                auto& cache = rng() % 2 ? sync_cache : async_cache;
+                auto op = rng() % 100;
+
+                if (op < 40) {
+                    expect_resource(cache.get(name), name);
+                } else if (op < 70) {
+                    expect_resource(cache.get(cache.intern(name)), name);
+                } else if (op < 95) {
+                    futures.emplace_back(name, cache.get_async(name));
+                } else if (op < 99) {
+                    ++reloads[key];
+                    expect_resource(cache.reload(name), name);
+                } else {
+                    // Counted first, so the check can't see its reloads without it.
+                    ++clears;
+                    cache.clear();
+                }
+
+                if (t == 0) {
+                    async_loader::update(std::chrono::microseconds(100));
+                }
+            }
+
+            for (auto& f : futures) {
+                expect_resource(f.second.get(), f.first);
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    drain_main_queue();
+
+    for (auto k = 0; k < NUM_STRESS_KEYS; ++k) {
+        std::string name = STRESS_KEYS[k];
+        auto limit = 1 + clears + reloads[k];
+        expect(factory_calls[k] <= limit && prepare_calls[k] <= limit,
+            name + " was loaded " + std::to_string(factory_calls[k]) + " and prepared " + std::to_string(prepare_calls[k])
+            + " times, but there were only " + std::to_string(clears) + " clears and " + std::to_string(reloads[k]) + " reloads");
+        expect(finish_calls[k] <= prepare_calls[k], name + " was finished more often than it was prepared");
+    }
+
+    std::cout << "Churn: " << clears << " clears, " << (reloads[0] + reloads[1] + reloads[2] + reloads[3] + reloads[4])
+        << " reloads." << std::endl;
+}
+
+// Threads load and drop resources over a tight budget while the main thread runs async_loader::update.
+// Nothing may be evicted anywhere but the main thread.
+void stress_eviction(int iterations) {
+    budget_cache.set_budget(2);
+    destroyed_off_main = 0;
+
+    std::atomic<int> running {STRESS_THREADS};
+    std::vector<std::thread> threads;
+
+    for (auto t = 0; t < STRESS_THREADS; ++t) {
+        threads.emplace_back([&, t]{
+            std::minstd_rand rng (t + 1);
+            for (auto i = 0; i < iterations; ++i) {
+                std::string name = STRESS_KEYS[rng() % NUM_STRESS_KEYS];
+                expect_resource(budget_cache.get(name), name);
+                std::this_thread::yield(); // Without holding on to it, so the main thread can evict it
+            }
+            --running;
+        });
+    }
+
+    while (running > 0) {
+        async_loader::update(std::chrono::microseconds(100));
+        std::this_thread::yield();
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    drain_main_queue();
+
+    auto stats = budget_cache.get_stats();
+    expect(stats.evictions > 0, "nothing was evicted");
+    expect(stats.resident_bytes <= stats.budget_bytes, "the budget wasn't met once the main thread caught up");
+    expect(destroyed_off_main == 0, std::to_string(destroyed_off_main) + " resources were destroyed off the main thread");
+
+    std::cout << "Eviction: " << stats.evictions << " evictions." << std::endl;
+}
+
+// A default handle names nothing, so looking it up must throw rather than index out of bounds.
+void check_invalid_handle() {
+    auto throws = [](auto&& lookup) {
+        try {
+            lookup();
+        } catch (const std::out_of_range&) {
+            return true;
+        }
+        return false;
+    };
+
+    resource_handle none;
+    expect(throws([&]{ sync_cache.get(none); }), "get() accepted a default handle");
+    expect(throws([&]{ sync_cache.get_key(none); }), "get_key() accepted a default handle");
+    expect(throws([&]{ sync_cache.is_loaded(none); }), "is_loaded() accepted a default handle");
+}
+
+int stress() {
+    check_invalid_handle();
+    stress_single_flight(20);
+    stress_churn(2000);
+    stress_eviction(2000);
+
+    if (failures > 0) {
+        return 1;
+    }
+
+    std::cout << "resource_cache: OK" << std::endl;
+    return 0;
+}
+
+// Contention benchmark
+
+// The cache before it was made thread-safe, behind the one lock it would have needed.
+class locked_map {
+public:
+    std::shared_ptr<fake_resource> get(const std::string& name) {
+        std::lock_guard<std::mutex> lock (mutex);
+        auto& ptr = map[std::make_tuple(name)];
+        if (!ptr) {
+            ptr = std::make_shared<fake_resource>(fake_resource{name});
+        }
+        return ptr;
+    }
+
+private:
+    std::mutex mutex;
+    std::map<std::tuple<std::string>, std::shared_ptr<fake_resource>> map;
+};
+
+// Returns the wall time per lookup, over all threads together, from the first thread starting to the last finishing.
+template <typename F>
+double time_threads(int thread_count, int lookups, F&& lookup) {
+    using clock = std::chrono::steady_clock;
+
+    start_line line (thread_count);
+    std::vector<std::thread> threads;
+    std::vector<clock::time_point> starts (thread_count);
+    std::vector<clock::time_point> ends (thread_count);
+
+    for (auto t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t]{
+            std::size_t local = 0;
+            line.arrive();
+            starts[t] = clock::now();
+            for (auto i = 0; i < lookups; ++i) {
+                local += lookup((i + t) % NUM_STRESS_KEYS)->name.size();
+            }
+            ends[t] = clock::now();
+            sink += local;
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    auto wall = *std::max_element(begin(ends), end(ends)) - *std::min_element(begin(starts), end(starts));
+    return std::chrono::duration<double>(wall).count() / (double(thread_count) * lookups);
+}
+
+void contention(int lookups) {
+    resource_cache<fake_resource, std::string> cache ([](const std::string& name) { return fake_resource{name}; });
+    locked_map map;
+
+    std::vector<std::string> names (std::begin(STRESS_KEYS), std::end(STRESS_KEYS));
+    std::vector<resource_handle> handles;
+    for (auto& name : names) {
+        handles.push_back(cache.intern(name));
+        cache.get(name);
+        map.get(name);
+    }
+
+    std::cout << lookups << " lookups per thread over " << NUM_STRESS_KEYS << " keys, wall ns per lookup over all threads, on "
+        << std::thread::hardware_concurrency() << " hardware threads." << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "locked map" << std::setw(14) << "get(key)"
+        << std::setw(14) << "get(handle)" << std::endl;
+
+    for (auto threads : {1, 2, 4, 8, 16}) {
+        auto map_time = time_threads(threads, lookups, [&](int k) { return map.get(names[k]); });
+        auto key_time = time_threads(threads, lookups, [&](int k) { return cache.get(names[k]); });
+        auto handle_time = time_threads(threads, lookups, [&](int k) { return cache.get(handles[k]); });
+
+        std::cout << std::setw(8) << threads << std::fixed << std::setprecision(1)
+            << std::setw(16) << map_time * 1e9
+            << std::setw(14) << key_time * 1e9
+            << std::setw(14) << handle_time * 1e9 << std::endl;
+    }
+}
+
+} //static
+
+int main(int argc, char* argv[]) {
+    auto run_stress = false;
+    auto run_contention = false;
+    auto frames = 1000;
+    std::vector<int> counts;
+
+    for (auto i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stress") {
+            run_stress = true;
+        } else if (arg == "--contention") {
+            run_contention = true;
+        } else if (arg.compare(0, 9, "--frames=") == 0) {
+            frames = std::max(std::atoi(arg.c_str() + 9), 1);
+        } else if (!arg.empty() && arg.find_first_not_of("0123456789") == std::string::npos) {
+            counts.push_back(std::atoi(arg.c_str()));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--stress] [--contention] [--frames=<n>] [sprites...]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (run_stress) {
+        return stress();
+    }
+
+    if (run_contention) {
+        contention(200000);
+        return 0;
+    }
+
+    if (counts.empty()) {
+        counts = {100, 1000, 10000};
+    }
+
+    const std::pair<const char*, mode> modes[] = {
+        {"std::map", mode::MAP},
+        {"get(key)", mode::KEY},
+        {"get(handle)", mode::HANDLE},
+        {"resolver", mode::RESOLVER},
+    };
+
+    std::cout << "Averaged over " << frames << " frames." << std::endl;
+    std::cout << std::setw(8) << "sprites" << std::setw(14) << "mode" << std::setw(12) << "us/frame"
+        << std::setw(14) << "ns/lookup" << std::setw(12) << "% frame" << std::endl;
+
+    for (auto count : counts) {
+        for (auto& m : modes) {
+            auto seconds = run(m.second, count, frames);
+            std::cout << std::setw(8) << count << std::setw(14) << m.first << std::fixed
+                << std::setw(12) << std::setprecision(2) << seconds / frames * 1e6
+                << std::setw(14) << std::setprecision(2) << seconds / (double(frames) * (count + 1)) * 1e9
+                << std::setw(12) << std::setprecision(3) << seconds / frames * 60 * 100 << std::endl;
+        }
+    }
+}
@@ -0,0 +1,179 @@
+// Bakes a font's MSDF glyphs into the binary atlas loaded by msdf_font.
+// Usage: LD40_fontbake <font.ttf> <output.msdf> [first_codepoint last_codepoint]
+//        LD40_fontbake --check <font.ttf>
+// The default range is printable ASCII.
+// --check only verifies that generateMSDF_RGBA8, on one thread and on all of them, is byte for byte what
+// generateMSDF and the old per-pixel conversion produce, for printable ASCII at several scales, with and
+// without inverseYAxis. It times both paths, and exits with 1 if any glyph differs.
+
+#include "font_bake.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// A glyph's shape, set up the way generate_msdf_glyph does it.
+struct glyph_shape {
+    int unicode;
+    msdfgen::Shape shape;
+    double left = 0;
+    double bottom = 0;
+    double right = 0;
+    double top = 0;
+};
+
+// The conversion generate_msdf_glyph did before generateMSDF_RGBA8.
+void generate_reference(std::vector<unsigned char>& out, int width, int height, const msdfgen::Shape& shape,
+        const msdfgen::Vector2& scale, const msdfgen::Vector2& translate) {
+    msdfgen::Bitmap<msdfgen::FloatRGB> msdf(width, height);
+    msdfgen::generateMSDF(msdf, shape, 4.0, scale, translate);
+
+    out.clear();
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            out.push_back(msdfgen::clamp(int(msdf(x, y).r*0x100), 0xff));
+            out.push_back(msdfgen::clamp(int(msdf(x, y).g*0x100), 0xff));
+            out.push_back(msdfgen::clamp(int(msdf(x, y).b*0x100), 0xff));
+            out.push_back(255);
+        }
+    }
+}
+
+int check(msdfgen::FontHandle* font) {
+    std::vector<glyph_shape> glyphs;
+    for (auto c = 32; c <= 126; ++c) {
+        glyph_shape g;
+        g.unicode = c;
+        if (msdfgen::loadGlyph(g.shape, font, c)) {
+            g.shape.normalize();
+            msdfgen::edgeColoringSimple(g.shape, 3.0);
+            g.shape.bounds(g.left, g.bottom, g.right, g.top);
+            glyphs.push_back(std::move(g));
+        }
+    }
+
+    using clock = std::chrono::steady_clock;
+    clock::duration reference_time {}, serial_time {}, threaded_time {};
+    std::vector<unsigned char> expected, serial, threaded;
+    auto count = 0;
+    auto mismatches = 0;
+
+    for (auto scale : {0.5, 1.0, 2.0, 4.0}) {
+        for (auto inverse_y : {false, true}) {
+            for (auto& g : glyphs) {
+                g.shape.inverseYAxis = inverse_y;
+
+                auto width = int((g.right - g.left + 2) * scale + 1);
+                auto height = int((g.top - g.bottom + 2) * scale + 1);
+                auto translate = msdfgen::Vector2(1 - g.left, 1 - g.bottom);
+
+                serial.resize(4*width*height);
+                threaded.resize(4*width*height);
+
+                auto start = clock::now();
+                generate_reference(expected, width, height, g.shape, scale, translate);
+                auto generated = clock::now();
+                msdfgen::generateMSDF_RGBA8(&serial[0], width, height, g.shape, 4.0, scale, translate, 1.00000001, 1);
+                auto generated_serial = clock::now();
+                msdfgen::generateMSDF_RGBA8(&threaded[0], width, height, g.shape, 4.0, scale, translate);
+                auto generated_threaded = clock::now();
+
+                reference_time += generated - start;
+                serial_time += generated_serial - generated;
+                threaded_time += generated_threaded - generated_serial;
+                ++count;
+
+                if (serial != expected || threaded != expected) {
+                    if (mismatches++ < 10) {
+                        std::cerr << "FAILED: code point " << g.unicode << " differs at scale " << scale
+                            << (inverse_y ? ", inverted" : "") << (serial != expected ? " on one thread" : " on all threads") << std::endl;
+                    }
+                }
+            }
+        }
+    }
+
+    auto glyphs_per_second = [&](clock::duration t) {
+        return count / std::chrono::duration<double>(t).count();
+    };
+
+    std::clog << count << " glyphs: generateMSDF and conversion " << glyphs_per_second(reference_time)
+        << " glyphs/sec, generateMSDF_RGBA8 " << glyphs_per_second(serial_time) << " glyphs/sec on one thread, "
+        << glyphs_per_second(threaded_time) << " glyphs/sec on all." << std::endl;
+
+    if (mismatches > 0) {
+        std::cerr << mismatches << " of " << count << " glyphs differ." << std::endl;
+        return 1;
+    }
+
+    std::cout << "generateMSDF_RGBA8: OK" << std::endl;
+    return 0;
+}
+
+} //static
+
+int main(int argc, char* argv[]) {
+    auto check_only = argc == 3 && std::string(argv[1]) == "--check";
+
+    if (!check_only && argc != 3 && argc != 5) {
+        std::cerr << "Usage: " << argv[0] << " <font.ttf> <output.msdf> [first_codepoint last_codepoint]" << std::endl;
+        std::cerr << "       " << argv[0] << " --check <font.ttf>" << std::endl;
+        return 1;
+    }
+
+    auto font_path = check_only ? argv[2] : argv[1];
+
+    auto first = 32;
+    auto last = 126;
+
+    if (argc == 5) {
+        first = std::stoi(argv[3], nullptr, 0);
+        last = std::stoi(argv[4], nullptr, 0);
+    }
+
+    auto ft = msdfgen::initializeFreetype();
+    if (!ft) {
+        std::cerr << "Failed to initialize FreeType." << std::endl;
+        return 1;
+    }
+
+    auto font = msdfgen::loadFont(ft, font_path);
+    if (!font) {
+        std::cerr << "Failed to load font " << font_path << "." << std::endl;
+        msdfgen::deinitializeFreetype(ft);
+        return 1;
+    }
+
+    if (check_only) {
+        auto result = check(font);
+        msdfgen::destroyFont(font);
+        msdfgen::deinitializeFreetype(ft);
+        return result;
+    }
+
+    std::vector<int> charset;
+    for (auto c = first; c <= last; ++c) {
+        charset.push_back(c);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto baked = bake_font(font, charset, MSDF_PAGE_SIZE);
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    msdfgen::destroyFont(font);
+    msdfgen::deinitializeFreetype(ft);
+
+    if (!save_baked_font(argv[2], baked)) {
+        std::cerr << "Failed to write " << argv[2] << "." << std::endl;
+        return 1;
+    }
+
+    std::clog << "Baked " << baked.glyphs.size() << " glyphs and " << baked.kerning.size() << " kerning pairs into " << baked.pages.size() << " pages in "
+        << seconds * 1000 << " ms (" << baked.glyphs.size() / seconds << " glyphs/sec)." << std::endl;
+
+    return 0;
+}
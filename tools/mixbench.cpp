@@ -0,0 +1,212 @@
+// Measures the cost of mixing the game's sounds, without an audio device.
+// Usage: LD40_mixbench [--verify] [--compact] [--music] [--seconds=<n>] [voices...]
+// Run it where the game runs, so it finds data.pak or data/.
+// For each voice count, that many looping sound effects, plus the music with --music, are mixed in a
+// tight loop through SoLoud's null backend. The default voice counts are 0, 1, 4, 8, 16, 32 and 64.
+// The music plays from a WavStream, so its decoding is counted. The game decodes it on another thread.
+// --verify only checks that each sound effect mixes to the same samples as float and as compact,
+// looping and not looping. It exits with 1 if not.
+
+#include "sound_clip.hpp"
+#include "assets.hpp"
+
+#include <soloud.h>
+#include <soloud_wavstream.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr unsigned SAMPLE_RATE = 44100;
+constexpr unsigned BLOCK_FRAMES = 512;
+constexpr unsigned CHANNELS = 2;
+
+const char* const SFX_NAMES[] = {"death", "elfattack", "gulp", "punch", "win"};
+
+struct result {
+    int voices;
+    double seconds;
+    double frames;
+};
+
+result run(SoLoud::Soloud& soloud, const std::vector<std::unique_ptr<sound_clip>>& clips, SoLoud::WavStream* music,
+        int voices, double audio_seconds) {
+    soloud.stopAll();
+    soloud.setMaxActiveVoiceCount(std::max(voices + 1, 16));
+
+    if (music) {
+        soloud.play(*music);
+    }
+
+    // Start the voices at different offsets so they don't all loop on the same block.
+    for (int i = 0; i < voices; ++i) {
+        auto& clip = *clips[i % clips.size()];
+        auto handle = soloud.play(clip, 1.f / std::max(voices, 1));
+        soloud.seek(handle, clip.getLength() * i / std::max(voices, 1));
+    }
+
+    std::vector<float> buffer (BLOCK_FRAMES * CHANNELS);
+    auto blocks = long(audio_seconds * SAMPLE_RATE / BLOCK_FRAMES);
+
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < blocks; ++i) {
+        soloud.mix(buffer.data(), BLOCK_FRAMES);
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return {voices, elapsed, double(blocks) * BLOCK_FRAMES};
+}
+
+// Mixes the clip alone for `audio_seconds`, long enough for every clip to loop.
+std::vector<float> render(SoLoud::Soloud& soloud, sound_clip& clip, double audio_seconds) {
+    soloud.stopAll();
+    soloud.play(clip);
+
+    auto blocks = long(audio_seconds * SAMPLE_RATE / BLOCK_FRAMES);
+    std::vector<float> output (blocks * BLOCK_FRAMES * CHANNELS);
+    for (long i = 0; i < blocks; ++i) {
+        soloud.mix(output.data() + i * BLOCK_FRAMES * CHANNELS, BLOCK_FRAMES);
+    }
+
+    soloud.stopAll();
+    return output;
+}
+
+int verify(SoLoud::Soloud& soloud, double audio_seconds) {
+    auto failed = false;
+
+    for (auto name : SFX_NAMES) {
+        auto path = std::string("sfx/") + name + ".wav";
+        auto bytes = assets::load(path);
+
+        sound_clip as_float;
+        sound_clip as_compact;
+        if (as_float.load(bytes, false) != SoLoud::SO_NO_ERROR || as_compact.load(bytes, true) != SoLoud::SO_NO_ERROR) {
+            std::cerr << "Failed to load " << path << "." << std::endl;
+            return 1;
+        }
+        if (as_float.is_compact() || !as_compact.is_compact()) {
+            std::cerr << "FAILED: " << name << " wasn't stored as asked." << std::endl;
+            return 1;
+        }
+
+        for (auto looping : {false, true}) {
+            as_float.setLooping(looping);
+            as_compact.setLooping(looping);
+
+            auto expected = render(soloud, as_float, audio_seconds);
+            auto actual = render(soloud, as_compact, audio_seconds);
+
+            auto mismatch = std::mismatch(expected.begin(), expected.end(), actual.begin());
+            auto looping_name = looping ? "looping" : "not looping";
+
+            if (mismatch.first != expected.end()) {
+                std::cerr << "FAILED: " << name << ", " << looping_name << ", differs at sample "
+                    << (mismatch.first - expected.begin()) << ": " << *mismatch.first << " vs " << *mismatch.second << std::endl;
+                failed = true;
+            } else {
+                std::cout << name << ", " << looping_name << ": OK" << std::endl;
+            }
+        }
+    }
+
+    return failed ? 1 : 0;
+}
+
+} //static
+
+int main(int argc, char* argv[]) {
+    auto verify_only = false;
+    auto compact = false;
+    auto with_music = false;
+    auto audio_seconds = 60.0;
+    std::vector<int> voice_counts;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--verify") {
+            verify_only = true;
+        } else if (arg == "--compact") {
+            compact = true;
+        } else if (arg == "--music") {
+            with_music = true;
+        } else if (arg.compare(0, 10, "--seconds=") == 0) {
+            audio_seconds = std::atof(arg.c_str() + 10);
+        } else if (!arg.empty() && arg.find_first_not_of("0123456789") == std::string::npos) {
+            voice_counts.push_back(std::atoi(arg.c_str()));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--verify] [--compact] [--music] [--seconds=<n>] [voices...]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (voice_counts.empty()) {
+        voice_counts = {0, 1, 4, 8, 16, 32, 64};
+    }
+
+    // Sources stop their voices when destroyed, so the engine has to outlive them.
+    SoLoud::Soloud soloud;
+    if (soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER, SAMPLE_RATE, BLOCK_FRAMES, CHANNELS) != SoLoud::SO_NO_ERROR) {
+        std::cerr << "Failed to initialize SoLoud." << std::endl;
+        return 1;
+    }
+
+    if (verify_only) {
+        return verify(soloud, 4);
+    }
+
+    std::vector<std::unique_ptr<sound_clip>> clips;
+    for (auto name : SFX_NAMES) {
+        auto path = std::string("sfx/") + name + ".wav";
+        clips.push_back(std::make_unique<sound_clip>());
+        if (clips.back()->load(assets::load(path), compact) != SoLoud::SO_NO_ERROR) {
+            std::cerr << "Failed to load " << path << "." << std::endl;
+            return 1;
+        }
+        clips.back()->setLooping(true);
+    }
+
+    assets::blob music_bytes;
+    std::unique_ptr<SoLoud::WavStream> music;
+    if (with_music) {
+        music_bytes = assets::load("music/TipsysTunes.ogg");
+        music = std::make_unique<SoLoud::WavStream>();
+        if (!music_bytes || music->loadMem(const_cast<unsigned char*>(music_bytes.data()), music_bytes.size(), false, false) != SoLoud::SO_NO_ERROR) {
+            std::cerr << "Failed to load music/TipsysTunes.ogg." << std::endl;
+            return 1;
+        }
+        music->setLooping(true);
+    }
+
+    std::cout << "Mixing " << audio_seconds << " s of " << CHANNELS << " channel audio at " << SAMPLE_RATE << " Hz in blocks of "
+        << BLOCK_FRAMES << " frames, " << (compact ? "compact" : "float") << " samples"
+        << (with_music ? ", with music" : "") << "." << std::endl;
+    std::cout << std::setw(8) << "voices" << std::setw(16) << "samples/s" << std::setw(12) << "realtime"
+        << std::setw(16) << "ns/voice/frame" << std::endl;
+
+    // Per-voice cost is measured against a mix with no sound effects, which still pays for the music and the output stage.
+    auto baseline = run(soloud, clips, music.get(), 0, audio_seconds);
+    auto baseline_per_frame = baseline.seconds / baseline.frames;
+
+    for (auto voices : voice_counts) {
+        auto r = voices == 0 ? baseline : run(soloud, clips, music.get(), voices, audio_seconds);
+        auto per_frame = r.seconds / r.frames;
+
+        std::cout << std::setw(8) << r.voices
+            << std::setw(16) << std::fixed << std::setprecision(0) << r.frames * CHANNELS / r.seconds
+            << std::setw(11) << std::setprecision(1) << r.frames / SAMPLE_RATE / r.seconds << "x";
+        if (voices > 0) {
+            std::cout << std::setw(16) << std::setprecision(2) << (per_frame - baseline_per_frame) / voices * 1e9;
+        } else {
+            std::cout << std::setw(16) << "-";
+        }
+        std::cout << std::endl;
+    }
+}
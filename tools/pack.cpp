@@ -0,0 +1,46 @@
+// Packs data files into the single archive read by the game at startup.
+// Usage: LD40_pack <output.pak> <data_dir> <files...>
+// Files may be given relative to data_dir or as paths inside it; they are stored relative to it.
+
+#include "asset_pack.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <output.pak> <data_dir> <files...>" << std::endl;
+        return 1;
+    }
+
+    std::string root = argv[2];
+    std::replace(begin(root), end(root), '\\', '/');
+    while (!root.empty() && root.back() == '/') {
+        root.pop_back();
+    }
+
+    std::vector<std::string> paths;
+
+    for (auto i = 3; i < argc; ++i) {
+        std::string path = argv[i];
+        std::replace(begin(path), end(path), '\\', '/');
+        if (path.compare(0, root.size() + 1, root + "/") == 0) {
+            path = path.substr(root.size() + 1);
+        }
+        paths.push_back(path);
+    }
+
+    std::sort(begin(paths), end(paths));
+    paths.erase(std::unique(begin(paths), end(paths)), end(paths));
+
+    if (!write_asset_pack(argv[1], root, paths)) {
+        std::cerr << "Failed to write " << argv[1] << "." << std::endl;
+        return 1;
+    }
+
+    std::clog << "Packed " << paths.size() << " files into " << argv[1] << "." << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+// Measures the CPU cost of queueing and submitting sprites through sprite_batch, against a stub GL.
+// Usage: LD40_spritebench [--check] [--frames=<n>] [sprites...]
+// For each sprite count, every frame adds that many sprites spread over four sheets, grouped by sheet like the
+// gameplay state's tiles and entities, then draws them. The default counts are 1000, 5000 and 20000.
+// The GLES2 fallback's CPU expansion of the same instances is timed separately.
+// --check only verifies, through the stub's call recorder, that each run of sprites sharing a texture is one
+// glDrawArraysInstanced of the right texture and instance count. It exits with 1 if not.
+
+#include "sprite_batch.hpp"
+#include "gl_stub.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int NUM_SHEETS = 4;
+
+std::vector<spritesheet> make_sheets() {
+    std::vector<spritesheet> sheets;
+    for (auto i = 0; i < NUM_SHEETS; ++i) {
+        auto texture = std::make_shared<sushi::texture_2d>(sushi::create_texture_2d(nullptr, 256, 256, false, false, false, false));
+        sheets.emplace_back(texture, 16, 16);
+    }
+    return sheets;
+}
+
+// Fills the batch in runs of `run_length` sprites per sheet, cycling through the sheets.
+void add_sprites(sprite_batch& batch, const std::vector<spritesheet>& sheets, int count, int run_length) {
+    for (auto i = 0; i < count; ++i) {
+        auto& sheet = sheets[(i / run_length) % sheets.size()];
+        batch.add(sheet, i % 256, {float(i % 64) * 16, float(i / 64) * 16});
+    }
+}
+
+int fail(const std::string& what) {
+    std::cerr << "FAILED: " << what << std::endl;
+    return 1;
+}
+
+int check(const std::vector<spritesheet>& sheets) {
+    sprite_batch batch (64);
+
+    // Four runs: 100 of each sheet in order.
+    add_sprites(batch, sheets, 400, 100);
+    if (batch.get_instances().size() != 400) {
+        return fail("queued " + std::to_string(batch.get_instances().size()) + " instances, expected 400");
+    }
+
+    gl_stub::reset();
+    batch.draw(glm::mat4(1));
+
+    auto& draws = gl_stub::get_draw_calls();
+    if (draws.size() != NUM_SHEETS) {
+        return fail(std::to_string(draws.size()) + " draw calls for " + std::to_string(NUM_SHEETS) + " textures");
+    }
+    for (auto i = 0; i < NUM_SHEETS; ++i) {
+        if (std::string(draws[i].function) != "glDrawArraysInstanced") {
+            return fail(std::string("draw ") + std::to_string(i) + " is " + draws[i].function);
+        }
+        if (draws[i].texture != sheets[i].get_texture().handle.get()) {
+            return fail("draw " + std::to_string(i) + " has the wrong texture bound");
+        }
+        if (draws[i].count != 6 || draws[i].instances != 100) {
+            return fail("draw " + std::to_string(i) + " draws " + std::to_string(draws[i].instances) + " instances of "
+                + std::to_string(draws[i].count) + " vertices");
+        }
+    }
+    if (gl_stub::get_call_count("glBufferData") != 1) {
+        return fail("instances were uploaded " + std::to_string(gl_stub::get_call_count("glBufferData")) + " times");
+    }
+    if (!batch.get_instances().empty()) {
+        return fail("the batch wasn't cleared by draw()");
+    }
+
+    // Returning to a texture starts a new run, since sprites are drawn in the order they were added.
+    gl_stub::reset();
+    batch.add(sheets[0], 0, {});
+    batch.add(sheets[1], 0, {});
+    batch.add(sheets[0], 0, {});
+    batch.draw(glm::mat4(1));
+    if (gl_stub::get_draw_calls().size() != 3) {
+        return fail("interleaved textures took " + std::to_string(gl_stub::get_draw_calls().size()) + " draws, expected 3");
+    }
+
+    // Nothing queued, nothing drawn.
+    gl_stub::reset();
+    batch.draw(glm::mat4(1));
+    if (!gl_stub::get_draw_calls().empty()) {
+        return fail("an empty batch drew");
+    }
+
+    std::cout << "sprite_batch: OK" << std::endl;
+    return 0;
+}
+
+} //static
+
+int main(int argc, char* argv[]) {
+    auto check_only = false;
+    auto frames = 200;
+    std::vector<int> counts;
+
+    for (auto i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--check") {
+            check_only = true;
+        } else if (arg.compare(0, 9, "--frames=") == 0) {
+            frames = std::atoi(arg.c_str() + 9);
+        } else if (!arg.empty() && arg.find_first_not_of("0123456789") == std::string::npos) {
+            counts.push_back(std::atoi(arg.c_str()));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--check] [--frames=<n>] [sprites...]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (counts.empty()) {
+        counts = {1000, 5000, 20000};
+    }
+
+    gl_stub::load();
+    auto sheets = make_sheets();
+
+    if (check_only) {
+        return check(sheets);
+    }
+
+    using clock = std::chrono::steady_clock;
+    using ns = std::chrono::duration<double, std::nano>;
+
+    std::cout << "Averaged over " << frames << " frames, " << NUM_SHEETS << " textures." << std::endl;
+    std::cout << std::setw(8) << "sprites" << std::setw(14) << "add ns/spr" << std::setw(14) << "draw ns/spr"
+        << std::setw(16) << "expand ns/spr" << std::setw(12) << "draws" << std::endl;
+
+    for (auto count : counts) {
+        sprite_batch batch (count);
+        std::vector<sprite_vertex> vertices;
+        ns add_time {}, draw_time {}, expand_time {};
+
+        for (auto f = 0; f < frames; ++f) {
+            auto start = clock::now();
+            add_sprites(batch, sheets, count, count / NUM_SHEETS + 1);
+            auto added = clock::now();
+
+            vertices.clear();
+            expand_sprite_instances(batch.get_instances(), vertices);
+            auto expanded = clock::now();
+
+            gl_stub::reset();
+            batch.draw(glm::mat4(1));
+            auto drawn = clock::now();
+
+            add_time += added - start;
+            expand_time += expanded - added;
+            draw_time += drawn - expanded;
+        }
+
+        auto per_sprite = [&](ns t) { return t.count() / (double(frames) * count); };
+
+        std::cout << std::setw(8) << count << std::fixed << std::setprecision(2)
+            << std::setw(14) << per_sprite(add_time)
+            << std::setw(14) << per_sprite(draw_time)
+            << std::setw(16) << per_sprite(expand_time)
+            << std::setw(12) << gl_stub::get_draw_calls().size() << std::endl;
+    }
+}
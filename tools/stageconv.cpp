@@ -0,0 +1,231 @@
+// Converts stages between JSON and the binary format the game and editor use.
+// Stages are only checked in as .stage, so convert to JSON to read or hand-edit one, then back.
+// Usage: LD40_stageconv <input> <output>
+//        LD40_stageconv --bench [size]
+// The direction is picked from the extensions: .json to .stage, or .stage to .json.
+// --bench generates a size by size stage, 4096 by default, and times loading it from memory in each format, best of 3.
+// JSON is loaded both by streaming, as read_stage_json does, and through a nlohmann::json tree, as the game used to.
+
+#include "stage.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int BENCH_RUNS = 3;
+
+bool ends_with(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+stage_data make_stage(int size) {
+    std::minstd_rand rng (size);
+    std::vector<tilemap::tile> tiles (std::size_t(size) * size);
+
+    for (auto& t : tiles) {
+        t.flags = std::uint8_t(rng() % 8);
+        t.background = std::uint8_t(rng() % 64);
+        t.foreground = std::uint8_t(rng() % 64);
+    }
+
+    stage_data stage;
+    stage.map = tilemap::tilemap(size, size, std::move(tiles));
+    stage.time_limit = 300;
+    stage.spawn = {size / 2, size / 2};
+
+    for (auto i = 0; i < 100; ++i) {
+        stage.elves.push_back({int(rng() % size), int(rng() % size)});
+        stage.beers.push_back({int(rng() % size), int(rng() % size)});
+    }
+
+    return stage;
+}
+
+// Writes the same JSON as stage_to_json(), without building a tree of 16 million tiles first.
+std::string make_json_text(const stage_data& stage) {
+    std::string text = "{\"num_rows\":" + std::to_string(stage.map.get_num_rows())
+        + ",\"num_cols\":" + std::to_string(stage.map.get_num_cols()) + ",\"tiles\":[";
+
+    auto num_tiles = std::size_t(stage.map.get_num_rows()) * stage.map.get_num_cols();
+    for (auto i = std::size_t(0); i < num_tiles; ++i) {
+        auto& t = stage.map.data()[i];
+        text += i ? ",[" : "[";
+        text += std::to_string(t.flags) + "," + std::to_string(t.background) + "," + std::to_string(t.foreground) + "]";
+    }
+
+    for (auto& cells : {std::make_pair("elves", &stage.elves), std::make_pair("beers", &stage.beers)}) {
+        text += std::string("],\"") + cells.first + "\":[";
+        for (auto& cell : *cells.second) {
+            text += &cell == cells.second->data() ? "[" : ",[";
+            text += std::to_string(cell.r) + "," + std::to_string(cell.c) + "]";
+        }
+    }
+
+    text += "],\"spawn\":{\"r\":" + std::to_string(stage.spawn.r) + ",\"c\":" + std::to_string(stage.spawn.c)
+        + "},\"time_limit\":" + std::to_string(stage.time_limit) + "}";
+
+    return text;
+}
+
+bool same_cells(const std::vector<stage_data::cell>& a, const std::vector<stage_data::cell>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const stage_data::cell& x, const stage_data::cell& y) {
+        return x.r == y.r && x.c == y.c;
+    });
+}
+
+bool same_stage(const stage_data& a, const stage_data& b) {
+    auto rows = a.map.get_num_rows();
+    auto cols = a.map.get_num_cols();
+    return rows == b.map.get_num_rows() && cols == b.map.get_num_cols()
+        && std::memcmp(a.map.data(), b.map.data(), std::size_t(rows) * cols * sizeof(tilemap::tile)) == 0
+        && a.time_limit == b.time_limit && a.spawn.r == b.spawn.r && a.spawn.c == b.spawn.c
+        && same_cells(a.elves, b.elves) && same_cells(a.beers, b.beers);
+}
+
+// How stages were loaded before read_stage_json: parse the whole tree, then walk it.
+bool read_stage_dom(const std::string& text, stage_data& out) {
+    auto json = nlohmann::json::parse(text);
+
+    std::vector<tilemap::tile> tiles;
+    tiles.reserve(json["tiles"].size());
+    for (auto& t : json["tiles"]) {
+        tiles.push_back({t[0], t[1], t[2]});
+    }
+    out.map = tilemap::tilemap(json["num_rows"], json["num_cols"], std::move(tiles));
+
+    auto time_limit = json.find("time_limit");
+    out.time_limit = time_limit != json.end() && !time_limit->is_null() ? int(*time_limit) : -1;
+
+    out.spawn = {json["spawn"]["r"], json["spawn"]["c"]};
+
+    out.elves.clear();
+    for (auto& cell : json["elves"]) {
+        out.elves.push_back({cell[0], cell[1]});
+    }
+
+    out.beers.clear();
+    for (auto& cell : json["beers"]) {
+        out.beers.push_back({cell[0], cell[1]});
+    }
+
+    return true;
+}
+
+// Best of BENCH_RUNS, in milliseconds, or -1 if a load fails or doesn't match the expected stage.
+// Each run loads into a fresh stage, as the game does.
+template <typename F>
+double time_load(const stage_data& expected, F&& load) {
+    auto best = 0.0;
+    for (auto i = 0; i < BENCH_RUNS; ++i) {
+        stage_data stage;
+        auto start = std::chrono::steady_clock::now();
+        if (!load(stage)) {
+            return -1;
+        }
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!same_stage(stage, expected)) {
+            return -1;
+        }
+        best = i == 0 ? ms : std::min(best, ms);
+    }
+    return best;
+}
+
+// Returns false if the load failed.
+bool print_result(const char* format, std::size_t bytes, double ms) {
+    std::cout << std::setw(10) << format << std::fixed << std::setprecision(1)
+        << std::setw(12) << bytes / (1024.0 * 1024.0);
+    if (ms < 0) {
+        std::cout << std::setw(12) << "failed" << std::endl;
+        return false;
+    }
+    std::cout << std::setw(12) << ms << std::endl;
+    return true;
+}
+
+int bench(int size) {
+    auto stage = make_stage(size);
+    auto binary = write_stage_binary(stage);
+    auto json = make_json_text(stage);
+
+    std::cout << "Loading a " << size << "x" << size << " stage from memory, best of " << BENCH_RUNS << "." << std::endl;
+    std::cout << std::setw(10) << "format" << std::setw(12) << "MiB" << std::setw(12) << "ms" << std::endl;
+
+    auto ok = print_result("binary", binary.size(), time_load(stage, [&](stage_data& out) {
+        return read_stage_binary(binary.data(), binary.size(), out);
+    }));
+
+    ok &= print_result("json", json.size(), time_load(stage, [&](stage_data& out) {
+        return read_stage_json(json.data(), json.data() + json.size(), out);
+    }));
+
+    ok &= print_result("json dom", json.size(), time_load(stage, [&](stage_data& out) {
+        return read_stage_dom(json, out);
+    }));
+
+    return ok ? 0 : 1;
+}
+
+} //static
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && argc <= 3 && std::string(argv[1]) == "--bench") {
+        return bench(argc == 3 ? std::max(std::atoi(argv[2]), 1) : 4096);
+    }
+
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input> <output>" << std::endl;
+        std::cerr << "       " << argv[0] << " --bench [size]" << std::endl;
+        return 1;
+    }
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+
+    std::ifstream in (input, std::ios::binary);
+    if (!in) {
+        std::cerr << "Failed to open " << input << "." << std::endl;
+        return 1;
+    }
+
+    std::vector<char> bytes ((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    stage_data stage;
+
+    auto valid = ends_with(input, ".json") ?
+        read_stage_json(bytes.data(), bytes.data() + bytes.size(), stage) :
+        read_stage_binary(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size(), stage);
+
+    if (!valid) {
+        std::cerr << input << " is not a valid stage." << std::endl;
+        return 1;
+    }
+
+    std::ofstream out (output, std::ios::binary);
+
+    if (ends_with(output, ".json")) {
+        out << stage_to_json(stage);
+    } else {
+        auto binary = write_stage_binary(stage);
+        out.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+    }
+
+    if (!out) {
+        std::cerr << "Failed to write " << output << "." << std::endl;
+        return 1;
+    }
+
+    std::clog << "Converted " << input << " (" << stage.map.get_num_rows() << "x" << stage.map.get_num_cols() << ") to " << output << "." << std::endl;
+
+    return 0;
+}
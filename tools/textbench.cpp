@@ -0,0 +1,131 @@
+// Measures the CPU cost of laying out and submitting HUD text, against a stub GL.
+// Usage: LD40_textbench [--frames=<n>] [--lines=<n>] [--font=<name>]
+// Run it where the game runs, so it finds data.pak or data/.
+// Every frame draws the same HUD, 40 lines of 50 characters by default, so 2000 characters:
+//   draw_string   lays out every line from scratch, as the states did before text_layout.
+//   static        keeps a text_layout per line, and nothing changes.
+//   one changes   keeps a text_layout per line, and one line, like a timer, changes every frame.
+//   all change    keeps a text_layout per line, and every line changes every frame.
+
+#include "text.hpp"
+#include "gl_stub.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr int LINE_LENGTH = 50;
+constexpr float TEXT_SIZE = 16;
+
+// A HUD line with a counter at the front, padded to LINE_LENGTH.
+std::string make_line(int line, int counter) {
+    auto str = "Line " + std::to_string(line) + ": " + std::to_string(counter) + " Score 1200 Lives 3 Keys 2 Time ";
+    str.resize(LINE_LENGTH, 'x');
+    return str;
+}
+
+enum class mode {
+    DRAW_STRING,
+    STATIC,
+    ONE_CHANGES,
+    ALL_CHANGE
+};
+
+struct result {
+    double seconds;
+    int draws;
+    int uploads;
+};
+
+result run(const std::shared_ptr<msdf_font>& font, mode m, int lines, int frames) {
+    auto proj = glm::mat4(1);
+    std::vector<text_layout> layouts;
+
+    for (auto i = 0; i < lines; ++i) {
+        layouts.emplace_back(font, make_line(i, 0), TEXT_SIZE, text_align::LEFT);
+    }
+
+    auto draws = 0;
+    auto uploads = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (auto f = 0; f < frames; ++f) {
+        gl_stub::reset();
+
+        for (auto i = 0; i < lines; ++i) {
+            auto pos = glm::vec2{0, i * TEXT_SIZE};
+            auto changes = m == mode::ALL_CHANGE || (m == mode::ONE_CHANGES && i == 0);
+            auto str = make_line(i, changes ? f + 1 : 0);
+
+            if (m == mode::DRAW_STRING) {
+                draw_string(*font, str, proj, pos, TEXT_SIZE, text_align::LEFT);
+            } else {
+                layouts[i].set(font, str, TEXT_SIZE, text_align::LEFT);
+                layouts[i].draw(proj, pos);
+            }
+        }
+
+        draws += gl_stub::get_draw_calls().size();
+        uploads += gl_stub::get_call_count("glBufferData");
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return {elapsed, draws / frames, uploads / frames};
+}
+
+} //static
+
+int main(int argc, char* argv[]) {
+    auto frames = 500;
+    auto lines = 40;
+    std::string font_name = "LiberationSans-Regular";
+
+    for (auto i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--frames=") == 0) {
+            frames = std::max(std::atoi(arg.c_str() + 9), 1);
+        } else if (arg.compare(0, 8, "--lines=") == 0) {
+            lines = std::max(std::atoi(arg.c_str() + 8), 1);
+        } else if (arg.compare(0, 7, "--font=") == 0) {
+            font_name = arg.substr(7);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--frames=<n>] [--lines=<n>] [--font=<name>]" << std::endl;
+            return 1;
+        }
+    }
+
+    gl_stub::load();
+    auto font = std::make_shared<msdf_font>(font_name);
+
+    auto chars = lines * LINE_LENGTH;
+
+    std::cout << "Averaged over " << frames << " frames of " << lines << " lines, " << chars << " characters." << std::endl;
+    std::cout << std::setw(14) << "mode" << std::setw(12) << "us/frame" << std::setw(12) << "ns/char"
+        << std::setw(10) << "draws" << std::setw(10) << "uploads" << std::endl;
+
+    const std::pair<const char*, mode> modes[] = {
+        {"draw_string", mode::DRAW_STRING},
+        {"static", mode::STATIC},
+        {"one changes", mode::ONE_CHANGES},
+        {"all change", mode::ALL_CHANGE},
+    };
+
+    for (auto& m : modes) {
+        auto r = run(font, m.second, lines, frames);
+
+        std::cout << std::setw(14) << m.first << std::fixed
+            << std::setw(12) << std::setprecision(1) << r.seconds / frames * 1e6
+            << std::setw(12) << std::setprecision(2) << r.seconds / frames / chars * 1e9
+            << std::setw(10) << r.draws
+            << std::setw(10) << r.uploads << std::endl;
+    }
+}